@@ -1,11 +1,10 @@
 #version 460
-layout (location = 0) in  vec3 inPosition;
-layout (location = 1) in  vec3 inNormal;
-layout (location = 2) in  vec2 inTexCoords;
-layout (location = 3) in  vec3 inTangent;
-layout (location = 4) in  vec3 inBiTangent;
-layout (location = 5) in ivec4 inBoneIDs;
-layout (location = 6) in  vec4 inBoneWeights;
+#include "include/vertex.glsl"
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in uint inNormal;
+layout (location = 2) in vec2 inTexCoords;
+layout (location = 3) in uint inTangent;
 
 layout (location = 0) out vec3 position;
 layout (location = 1) out vec3 normal;
@@ -55,10 +54,14 @@ void main()
 
     mat3 model3x3 = mat3(Constant.model);
 
+    vec3 localNormal    = UnpackNormal(inNormal);
+    vec3 localTangent   = UnpackTangent(inTangent);
+    vec3 localBitangent = UnpackBitangent(localNormal, localTangent, inTangent);
+
     mat3 normalMatrix = transpose(inverse(model3x3));
-    tangent   = normalize(normalMatrix * inTangent);
-    bitangent = normalize(normalMatrix * inBiTangent);
-    normal    = normalize(normalMatrix * inNormal);
+    tangent   = normalize(normalMatrix * localTangent);
+    bitangent = normalize(normalMatrix * localBitangent);
+    normal    = normalize(normalMatrix * localNormal);
 
     texCoords = inTexCoords;
 
@@ -0,0 +1,83 @@
+// the vertex as it is stored in the vertex buffer, see PackedVertex in Vertex.ixx
+// the position is three floats instead of a vec3, a vec3 would be aligned to 16 bytes
+struct PackedVertex
+{
+	float positionX;
+	float positionY;
+	float positionZ;
+	uint normal;
+	uint tangent;
+	uint textureCoordinates;
+};
+
+struct Vertex
+{
+	vec3 position;
+	vec3 normal;
+	vec2 textureCoordinates;
+	vec3 tangent;
+	vec3 bitangent;
+};
+
+vec2 EncodeOctahedral(vec3 v)
+{
+	float sum = abs(v.x) + abs(v.y) + abs(v.z);
+	if (sum == 0.0) // a zero vector has no direction, this decodes to +Z like the encoder in Vertex.cpp
+		return vec2(0.0);
+
+	v /= sum;
+	if (v.z >= 0.0)
+		return v.xy;
+
+	return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec3 DecodeOctahedral(vec2 e)
+{
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-v.z, 0.0);
+	v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+	return normalize(v);
+}
+
+vec3 UnpackNormal(uint normal)
+{
+	return DecodeOctahedral(unpackSnorm2x16(normal));
+}
+
+vec3 UnpackTangent(uint tangent)
+{
+	return DecodeOctahedral(unpackSnorm2x16(tangent));
+}
+
+vec3 UnpackBitangent(vec3 normal, vec3 tangent, uint packedTangent)
+{
+	return cross(normal, tangent) * ((packedTangent & 1u) != 0u ? -1.0 : 1.0);
+}
+
+uint PackNormal(vec3 normal)
+{
+	return packSnorm2x16(EncodeOctahedral(normal));
+}
+
+uint PackTangent(vec3 tangent, uint packedTangent) // keeps the sign of the bitangent of the packed tangent
+{
+	return (packSnorm2x16(EncodeOctahedral(tangent)) & ~1u) | (packedTangent & 1u);
+}
+
+vec3 GetPosition(PackedVertex vertex)
+{
+	return vec3(vertex.positionX, vertex.positionY, vertex.positionZ);
+}
+
+Vertex UnpackVertex(PackedVertex vertex)
+{
+	Vertex ret;
+	ret.position = GetPosition(vertex);
+	ret.normal = UnpackNormal(vertex.normal);
+	ret.textureCoordinates = unpackHalf2x16(vertex.textureCoordinates);
+	ret.tangent = UnpackTangent(vertex.tangent);
+	ret.bitangent = UnpackBitangent(ret.normal, ret.tangent, vertex.tangent);
+
+	return ret;
+}
\ No newline at end of file
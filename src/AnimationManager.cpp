@@ -5,6 +5,7 @@ import std;
 import Renderer.CommandBuffer;
 import Renderer.ComputePipeline;
 import Renderer.Buffer;
+import Renderer.Vertex;
 import Renderer;
 
 import System.CriticalSection;
@@ -83,22 +84,32 @@ void AnimationManager::ComputeAnimations(float delta)
 	}
 }
 
-void AnimationManager::ApplyAnimations(const CommandBuffer& commandBuffer)
+void AnimationManager::ApplyAnimations(const CommandBuffer& commandBuffer, const std::span<const SkinnedMeshRange>& meshes)
 {
 	win32::CriticalLockGuard guard(section);
+	if (meshes.empty())
+		return;
+
 	if (true) // disable
 	{
-		VkBufferCopy copy{};
-		copy.size = Renderer::g_defaultVertexBuffer.GetSize() * sizeof(Vertex);
-
-		if (copy.size == 0)
-			return;
-
-		commandBuffer.CopyBuffer(Renderer::g_defaultVertexBuffer.GetBufferHandle(), Renderer::g_vertexBuffer.GetBufferHandle(), 1, &copy);
+		// only the skinned meshes are copied, the static meshes are never changed after their upload
+		std::vector<VkBufferCopy> copies(meshes.size());
+		for (std::size_t i = 0; i < meshes.size(); i++)
+		{
+			copies[i].srcOffset = meshes[i].sourceOffset * sizeof(PackedVertex);
+			copies[i].dstOffset = meshes[i].destinationOffset * sizeof(PackedVertex);
+			copies[i].size = meshes[i].vertexCount * sizeof(PackedVertex);
+		}
+
+		commandBuffer.CopyBuffer(Renderer::g_defaultVertexBuffer.GetBufferHandle(), Renderer::g_vertexBuffer.GetBufferHandle(), static_cast<std::uint32_t>(copies.size()), copies.data());
 		return;
 	}
 
-	computeShader->Execute(commandBuffer, static_cast<uint32_t>(Renderer::g_defaultVertexBuffer.GetSize() / 16) + 1, 1, 1);
+	for (const SkinnedMeshRange& mesh : meshes)
+	{
+		computeShader->PushConstant(commandBuffer, mesh, VK_SHADER_STAGE_COMPUTE_BIT);
+		computeShader->Execute(commandBuffer, mesh.vertexCount / 16 + 1, 1, 1);
+	}
 
 	VkBufferMemoryBarrier barrier{};
 	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
@@ -121,9 +132,9 @@ void AnimationManager::CreateShader()
 
 	computeShader = std::make_unique<ComputePipeline>("shaders/uncompiled/anim.comp");
 
-	computeShader->BindBufferToName("indexBuffer", Renderer::g_indexBuffer.GetBufferHandle());
 	computeShader->BindBufferToName("vertexBuffer", Renderer::g_vertexBuffer.GetBufferHandle());
 	computeShader->BindBufferToName("sourceBuffer", Renderer::g_defaultVertexBuffer.GetBufferHandle());
+	computeShader->BindBufferToName("skinningBuffer", Renderer::g_skinningBuffer.GetBufferHandle());
 	computeShader->BindBufferToName("animMatrices", mat4Buffer.Get());
 }
 
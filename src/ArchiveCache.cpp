@@ -0,0 +1,92 @@
+module IO.ArchiveCache;
+
+import std;
+
+float ArchiveCache::Statistics::GetHitRate() const
+{
+	std::uint64_t total = hits + misses;
+	return total == 0 ? 0.0f : static_cast<float>(hits) / static_cast<float>(total);
+}
+
+ArchiveCache::ArchiveCache(std::uint64_t budget)
+{
+	statistics.budget = budget;
+}
+
+std::shared_ptr<const std::vector<char>> ArchiveCache::Find(std::uint64_t hash, std::uint64_t size)
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+
+	auto it = lookup.find(hash);
+	if (it == lookup.end() || it->second->data->size() != size) // the size is checked as well to make a collision even less likely
+	{
+		statistics.misses++;
+		return nullptr;
+	}
+
+	entries.splice(entries.begin(), entries, it->second); // moving the node keeps the iterator in the lookup valid
+	statistics.hits++;
+
+	return it->second->data;
+}
+
+void ArchiveCache::Insert(std::uint64_t hash, std::shared_ptr<const std::vector<char>> data)
+{
+	std::uint64_t size = data->size();
+	if (size > statistics.budget)
+		return;
+
+	std::lock_guard<std::mutex> lockGuard(mutex);
+
+	auto it = lookup.find(hash);
+	if (it != lookup.end()) // another thread has read the same data at the same time
+	{
+		entries.splice(entries.begin(), entries, it->second);
+		return;
+	}
+
+	Evict(size);
+
+	entries.push_front(Entry{ hash, std::move(data) });
+	lookup.emplace(hash, entries.begin());
+
+	statistics.size += size;
+}
+
+void ArchiveCache::Evict(std::uint64_t required)
+{
+	while (!entries.empty() && statistics.size + required > statistics.budget)
+	{
+		const Entry& entry = entries.back();
+
+		statistics.size -= entry.data->size();
+		statistics.evictions++;
+
+		lookup.erase(entry.hash);
+		entries.pop_back();
+	}
+}
+
+void ArchiveCache::Clear()
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+
+	entries.clear();
+	lookup.clear();
+	statistics.size = 0;
+}
+
+ArchiveCache::Statistics ArchiveCache::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+	return statistics;
+}
+
+void ArchiveCache::ResetStatistics()
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+
+	statistics.hits = 0;
+	statistics.misses = 0;
+	statistics.evictions = 0;
+}
\ No newline at end of file
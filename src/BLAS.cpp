@@ -8,28 +8,28 @@ import Renderer.Vertex;
 import Renderer.Vulkan;
 import Renderer;
 
-static std::uint32_t GetFaceCount(StorageBuffer<std::uint32_t>::Memory indexMemory)
+static std::uint32_t GetFaceCount(IndexMemory indexMemory)
 {
-	return static_cast<std::uint32_t>(Renderer::g_indexBuffer.GetItemCount(indexMemory) / 3);
+	return static_cast<std::uint32_t>(Renderer::GetIndexCount(indexMemory) / 3);
 }
 
-static VkAccelerationStructureGeometryTrianglesDataKHR GetTrianglesData(StorageBuffer<Vertex>::Memory vertexMemory, StorageBuffer<std::uint32_t>::Memory indexMemory)
+static VkAccelerationStructureGeometryTrianglesDataKHR GetTrianglesData(StorageBuffer<PackedVertex>::Memory vertexMemory, IndexMemory indexMemory)
 {
 	VkAccelerationStructureGeometryTrianglesDataKHR data{};
 	data.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
 	data.vertexData = { Renderer::g_vertexBuffer.GetDeviceAddressOffset(vertexMemory) };
-	data.indexData  = { Renderer::g_indexBuffer.GetDeviceAddressOffset(indexMemory)   };
+	data.indexData  = { indexMemory.type == VK_INDEX_TYPE_UINT16 ? Renderer::g_index16Buffer.GetDeviceAddressOffset(indexMemory.memory) : Renderer::g_indexBuffer.GetDeviceAddressOffset(indexMemory.memory) };
 	data.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
-	data.vertexStride = sizeof(Vertex);
+	data.vertexStride = sizeof(PackedVertex);
 	data.maxVertex = static_cast<std::uint32_t>(Renderer::g_vertexBuffer.GetItemCount(vertexMemory));
-	data.indexType = VK_INDEX_TYPE_UINT32;
+	data.indexType = indexMemory.type;
 
 	data.transformData = { 0 };
 
 	return data;
 }
 
-BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(StorageBuffer<Vertex>::Memory vertexMemory, StorageBuffer<std::uint32_t>::Memory indexMemory)
+BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(StorageBuffer<PackedVertex>::Memory vertexMemory, IndexMemory indexMemory)
 {
 	VkAccelerationStructureGeometryKHR geometry{};
 	geometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
@@ -43,13 +43,13 @@ BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(StorageBuffer
 	BuildAS(&geometry, faceCount, VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR);
 }
 
-BottomLevelAccelerationStructure* BottomLevelAccelerationStructure::Create(StorageBuffer<Vertex>::Memory vertexMemory, StorageBuffer<std::uint32_t>::Memory indexMemory)
+BottomLevelAccelerationStructure* BottomLevelAccelerationStructure::Create(StorageBuffer<PackedVertex>::Memory vertexMemory, IndexMemory indexMemory)
 {
 	BottomLevelAccelerationStructure* BLAS = new BottomLevelAccelerationStructure(vertexMemory, indexMemory);
 	return BLAS;
 }
 
-void BottomLevelAccelerationStructure::RebuildGeometry(VkCommandBuffer commandBuffer, StorageBuffer<Vertex>::Memory vertexMemory, StorageBuffer<std::uint32_t>::Memory indexMemory)
+void BottomLevelAccelerationStructure::RebuildGeometry(VkCommandBuffer commandBuffer, StorageBuffer<PackedVertex>::Memory vertexMemory, IndexMemory indexMemory)
 {
 	VkAccelerationStructureGeometryKHR geometry{};
 	geometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
@@ -13,6 +13,9 @@ BinaryStream::BinaryStream(const std::vector<char>& data) : data(data)
 
 void BinaryStream::Read(char* dst, std::size_t count)
 {
+	if (count == 0) // the offset can be at the very end, which cannot be indexed
+		return;
+
 	assert(offset + count <= data.size());
 	std::memcpy(dst, &data[offset], count);
 	offset += count;
@@ -23,6 +26,16 @@ void BinaryStream::Write(const char* src, std::size_t count)
 	data.insert(data.end(), src, src + count);
 }
 
+// streams are often reserved for every piece that is written to them, reserving the exact size would then copy the entire stream every time
+void BinaryStream::Reserve(std::size_t additionalSize)
+{
+	std::size_t required = data.size() + additionalSize;
+	if (required <= data.capacity())
+		return;
+
+	data.reserve(std::max(required, data.capacity() * 2));
+}
+
 void BinaryStream::Clear()
 {
 	data.clear();
@@ -51,6 +64,9 @@ BinarySpan::BinarySpan(const std::vector<char>& data) : data(data)
 
 void BinarySpan::Read(char* dst, size_t count) const
 {
+	if (count == 0) // the offset can be at the very end, which cannot be indexed
+		return;
+
 	assert(offset + count <= data.size());
 	std::memcpy(dst, &data[offset], count);
 	offset += count;
@@ -0,0 +1,296 @@
+module;
+
+#include <lz4/lz4.h>
+#include <lz4/lz4hc.h>
+#include <zstd/zstd.h>
+#include <zstd/zdict.h>
+
+module IO.Compression;
+
+import std;
+
+static int GetLevel(CompressionCodec codec, int level)
+{
+	if (level != 0)
+		return level;
+
+	switch (codec)
+	{
+	case CompressionCodec::LZ4HC:
+		return LZ4HC_CLEVEL_DEFAULT;
+	case CompressionCodec::Zstd:
+		return ZSTD_CLEVEL_DEFAULT;
+	}
+	return 1;
+}
+
+// creating these for every compression is expensive compared to compressing a small piece of data, so every thread keeps its own
+struct CompressionContexts
+{
+	CompressionContexts() = default;
+	~CompressionContexts()
+	{
+		::LZ4_freeStream(lz4);
+		::LZ4_freeStreamHC(lz4hc);
+		::ZSTD_freeCCtx(zstdCompress);
+		::ZSTD_freeDCtx(zstdDecompress);
+	}
+
+	CompressionContexts(const CompressionContexts&) = delete;
+	CompressionContexts& operator=(const CompressionContexts&) = delete;
+
+	LZ4_stream_t* lz4 = ::LZ4_createStream();
+	LZ4_streamHC_t* lz4hc = ::LZ4_createStreamHC();
+	ZSTD_CCtx* zstdCompress = ::ZSTD_createCCtx();
+	ZSTD_DCtx* zstdDecompress = ::ZSTD_createDCtx();
+};
+
+static CompressionContexts& GetContexts()
+{
+	thread_local CompressionContexts contexts;
+	return contexts;
+}
+
+// LZ4 only looks at the last 64 KB of a dictionary
+static std::span<const char> GetLZ4Dictionary(const CompressionDictionary* pDictionary)
+{
+	std::span<const char> data = pDictionary->GetData();
+	return data.size() > 64 * 1024 ? data.last(64 * 1024) : data;
+}
+
+// the compressed data must be smaller than the original, otherwise it will not be worth decompressing
+static std::vector<char> CompressLZ4(const std::span<const char>& src, CompressionCodec codec, int level, const CompressionDictionary* pDictionary)
+{
+	std::vector<char> ret(src.size() - 1);
+
+	int srcSize = static_cast<int>(src.size());
+	int dstSize = static_cast<int>(ret.size());
+	int compressedCount = 0;
+
+	if (pDictionary == nullptr)
+	{
+		compressedCount = codec == CompressionCodec::LZ4HC
+			? ::LZ4_compress_HC(src.data(), ret.data(), srcSize, dstSize, level)
+			: ::LZ4_compress_fast(src.data(), ret.data(), srcSize, dstSize, level); // the level of LZ4 is its acceleration
+	}
+	else if (codec == CompressionCodec::LZ4HC)
+	{
+		std::span<const char> dictionary = GetLZ4Dictionary(pDictionary);
+		LZ4_streamHC_t* pStream = GetContexts().lz4hc;
+
+		::LZ4_resetStreamHC_fast(pStream, level);
+		::LZ4_loadDictHC(pStream, dictionary.data(), static_cast<int>(dictionary.size()));
+		compressedCount = ::LZ4_compress_HC_continue(pStream, src.data(), ret.data(), srcSize, dstSize);
+	}
+	else
+	{
+		std::span<const char> dictionary = GetLZ4Dictionary(pDictionary);
+		LZ4_stream_t* pStream = GetContexts().lz4;
+
+		::LZ4_loadDict(pStream, dictionary.data(), static_cast<int>(dictionary.size())); // this also resets the stream
+		compressedCount = ::LZ4_compress_fast_continue(pStream, src.data(), ret.data(), srcSize, dstSize, level);
+	}
+
+	if (compressedCount <= 0)
+		return {};
+
+	ret.resize(compressedCount);
+	return ret;
+}
+
+static std::vector<char> CompressZstd(const std::span<const char>& src, int level, const CompressionDictionary* pDictionary)
+{
+	std::vector<char> ret(src.size() - 1);
+
+	std::size_t compressedCount = pDictionary == nullptr
+		? ::ZSTD_compress(ret.data(), ret.size(), src.data(), src.size(), level)
+		: ::ZSTD_compress_usingDict(GetContexts().zstdCompress, ret.data(), ret.size(), src.data(), src.size(), pDictionary->GetData().data(), pDictionary->GetData().size(), level);
+
+	if (::ZSTD_isError(compressedCount))
+		return {};
+
+	ret.resize(compressedCount);
+	return ret;
+}
+
+CompressionDictionary::CompressionDictionary(std::vector<char> data) : data(std::move(data))
+{
+	zstdDictionary = ::ZSTD_createDDict(this->data.data(), this->data.size());
+}
+
+CompressionDictionary::~CompressionDictionary()
+{
+	::ZSTD_freeDDict(zstdDictionary);
+}
+
+std::span<const char> CompressionDictionary::GetData() const
+{
+	return data;
+}
+
+const ZSTD_DDict* CompressionDictionary::GetZstdDictionary() const
+{
+	return zstdDictionary;
+}
+
+float CodecBenchmark::GetRatio() const
+{
+	return compressedSize == 0 ? 0.0f : static_cast<float>(uncompressedSize) / static_cast<float>(compressedSize);
+}
+
+static float GetSpeed(std::uint64_t size, double time)
+{
+	return time == 0.0 ? 0.0f : static_cast<float>(size / (1024.0 * 1024.0) / time);
+}
+
+float CodecBenchmark::GetCompressionSpeed() const
+{
+	return GetSpeed(uncompressedSize, compressionTime);
+}
+
+float CodecBenchmark::GetDecompressionSpeed() const
+{
+	return GetSpeed(uncompressedSize, decompressionTime);
+}
+
+namespace Compression
+{
+	std::string_view CodecToString(CompressionCodec codec)
+	{
+		switch (codec)
+		{
+		case CompressionCodec::Store:
+			return "Store";
+		case CompressionCodec::LZ4:
+			return "LZ4";
+		case CompressionCodec::LZ4HC:
+			return "LZ4HC";
+		case CompressionCodec::Zstd:
+			return "Zstd";
+		}
+		return "Unknown";
+	}
+
+	std::vector<char> Compress(const std::span<const char>& src, CompressionCodec codec, int level, const CompressionDictionary* pDictionary)
+	{
+		if (src.size() <= 1)
+			return {};
+
+		level = GetLevel(codec, level);
+
+		switch (codec)
+		{
+		case CompressionCodec::LZ4:
+		case CompressionCodec::LZ4HC:
+			if (src.size() > LZ4_MAX_INPUT_SIZE) // zstd has no such limit, so only LZ4 falls back to storing the data
+				return {};
+
+			return CompressLZ4(src, codec, level, pDictionary);
+		case CompressionCodec::Zstd:
+			return CompressZstd(src, level, pDictionary);
+		}
+		return {}; // the data is stored as is
+	}
+
+	bool Decompress(const std::span<const char>& src, const std::span<char>& dst, CompressionCodec codec, const CompressionDictionary* pDictionary)
+	{
+		switch (codec)
+		{
+		case CompressionCodec::Store:
+			if (src.size() != dst.size())
+				return false;
+
+			std::memcpy(dst.data(), src.data(), src.size());
+			return true;
+
+		case CompressionCodec::LZ4:
+		case CompressionCodec::LZ4HC: // LZ4HC produces the same format as LZ4
+		{
+			if (src.size() > std::numeric_limits<int>::max() || dst.size() > std::numeric_limits<int>::max()) // LZ4 never produces these, so the entry is damaged
+				return false;
+
+			int srcSize = static_cast<int>(src.size());
+			int dstSize = static_cast<int>(dst.size());
+
+			if (pDictionary == nullptr)
+				return ::LZ4_decompress_safe(src.data(), dst.data(), srcSize, dstSize) == dstSize;
+
+			std::span<const char> dictionary = GetLZ4Dictionary(pDictionary);
+			return ::LZ4_decompress_safe_usingDict(src.data(), dst.data(), srcSize, dstSize, dictionary.data(), static_cast<int>(dictionary.size())) == dstSize;
+		}
+		case CompressionCodec::Zstd:
+		{
+			std::size_t decompressedCount = pDictionary == nullptr
+				? ::ZSTD_decompress(dst.data(), dst.size(), src.data(), src.size())
+				: ::ZSTD_decompress_usingDDict(GetContexts().zstdDecompress, dst.data(), dst.size(), src.data(), src.size(), pDictionary->GetZstdDictionary());
+
+			return !::ZSTD_isError(decompressedCount) && decompressedCount == dst.size();
+		}
+		}
+		return false;
+	}
+
+	std::vector<char> TrainDictionary(const std::vector<std::span<const char>>& samples, std::size_t maxSize)
+	{
+		std::vector<char> buffer; // the samples have to be laid out after each other
+		std::vector<std::size_t> sizes;
+		sizes.reserve(samples.size());
+
+		for (const std::span<const char>& sample : samples)
+		{
+			buffer.insert(buffer.end(), sample.begin(), sample.end());
+			sizes.push_back(sample.size());
+		}
+
+		std::vector<char> ret(maxSize);
+
+		std::size_t size = ::ZDICT_trainFromBuffer(ret.data(), ret.size(), buffer.data(), sizes.data(), static_cast<unsigned int>(sizes.size()));
+		if (::ZDICT_isError(size)) // this mostly happens if there are too few samples
+			return {};
+
+		ret.resize(size);
+		return ret;
+	}
+
+	std::vector<CodecBenchmark> GetBenchmarkCodecs()
+	{
+		return
+		{
+			{ CompressionCodec::LZ4,   0 },
+			{ CompressionCodec::LZ4HC, 0 },
+			{ CompressionCodec::LZ4HC, LZ4HC_CLEVEL_MAX },
+			{ CompressionCodec::Zstd,  1 },
+			{ CompressionCodec::Zstd,  0 },
+			{ CompressionCodec::Zstd,  9 },
+		};
+	}
+
+	void Benchmark(const std::span<const char>& sample, std::vector<CodecBenchmark>& results)
+	{
+		std::vector<char> decompressed(sample.size());
+
+		for (CodecBenchmark& result : results)
+		{
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			std::vector<char> compressed = Compress(sample, result.codec, result.level);
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+			result.compressionTime += std::chrono::duration<double>(end - begin).count();
+			result.uncompressedSize += sample.size();
+
+			if (compressed.empty()) // the data would be stored as is
+			{
+				result.compressedSize += sample.size();
+				continue;
+			}
+
+			result.compressedSize += compressed.size();
+
+			begin = std::chrono::steady_clock::now();
+			Decompress(compressed, decompressed, result.codec);
+			end = std::chrono::steady_clock::now();
+
+			result.decompressionTime += std::chrono::duration<double>(end - begin).count();
+		}
+	}
+}
\ No newline at end of file
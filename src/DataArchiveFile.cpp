@@ -1,122 +1,745 @@
 module;
 
-#include <lz4/lz4.h>
 #include <cassert>
 
 module IO.DataArchiveFile;
 
 import std;
 
+import IO.BinaryStream;
+import IO.Compression;
+import IO.Hash;
+
+// the archive is append-only and is laid out like this:
+//
+// data blocks, every data block starts with a 64 bit value showing the uncompressed size
+// the dictionary
+// the footer
+//
 // the dictionary is serialized like this:
 //
 // entry count: unsigned 32 bit
-// entry count amount of entries:
+// entry count amount of entry records (see EntryRecord), sorted by key
+// the record of the data block holding the compression dictionary, its size is 0 if the archive has no compression dictionary
+// the record of the data block holding the name table, its size is 0 if the archive has no name table
+//
+// the records have a fixed size, so the entire dictionary is read with a single copy. the identifiers are not needed to find an entry,
+// they are only kept in the name table for debugging. the name table is compressed like any other entry and looks like this:
+//
+// name count: unsigned 32 bit
+// name count amount of names:
+//   key: unsigned 64 bit
 //   string, starts with a 32 bit value dictating the string length
-//   data offset from the beginning of the file: unsigned 64 bit
-//   compressed size of the data: unsigned 64 bit
-//   uncompressed size of the data: unsigned 64 bit
-// every data block starts with a 64 bit value showing the uncompressed size
+//
+// archives before version 5 store the identifier of every entry in the dictionary instead, see ReadDictionary for that layout
+//
+// large entries are split into independently compressed chunks so that they can be (de)compressed in parallel, their data looks like this:
+//
+// chunk count: unsigned 32 bit
+// chunk count amount of compressed chunk sizes: unsigned 32 bit
+// the compressed chunks, every chunk except for the last one has an uncompressed size of CHUNK_SIZE
+//
+// every write appends the new data blocks and a new dictionary + footer, the old dictionary stays intact until the new footer is written.
+// identical data is only stored once, multiple entries can point to the same data block.
+// archives written before the footer existed have their dictionary at the start of the file, without the uncompressed size and hash.
+// entries without a codec are compressed with LZ4, or are stored as is if their compressed size is the same as the uncompressed size.
+// small entries can be compressed with a dictionary that is shared by the entire archive, the dictionary itself is stored as is in a regular data block
+
+struct Footer
+{
+	std::uint64_t dictionaryOffset = 0;
+	std::uint64_t dictionarySize = 0;
+	std::uint32_t version = 0;
+	std::uint32_t magic = 0;
+};
+
+static constexpr std::uint32_t ARCHIVE_MAGIC = 0x43524148; // "HARC"
+static constexpr std::uint32_t ARCHIVE_VERSION = 5;
+
+static constexpr std::uint32_t LEGACY_ARCHIVE_VERSION = 0;
+static constexpr std::uint32_t FLAGS_ARCHIVE_VERSION = 2; // the first version that stores the flags of an entry
+static constexpr std::uint32_t CODEC_ARCHIVE_VERSION = 3; // the first version that stores the codec of an entry
+static constexpr std::uint32_t COMPRESSION_DICTIONARY_ARCHIVE_VERSION = 4; // the first version that can store a compression dictionary
+static constexpr std::uint32_t HASHED_ARCHIVE_VERSION = 5; // the first version that stores the entries by key, with the identifiers in a separate name table
 
-DataArchiveFile::DataArchiveFile(const std::string& file, OpenMethod method) : stream(file, static_cast<ReadWriteFile::OpenMethod>(method))
+static constexpr std::uint64_t CHUNK_SIZE = 256 * 1024;
+static constexpr std::uint64_t CHUNKED_THRESHOLD = 4 * CHUNK_SIZE; // smaller entries dont gain enough from multiple threads to make up for the overhead
+static constexpr std::uint64_t DICTIONARY_THRESHOLD = 4 * 1024;    // larger entries compress well enough on their own
+
+static constexpr std::size_t MAX_POOLED_BUFFER_COUNT = 64;
+static constexpr std::size_t MAX_POOLED_BUFFER_SIZE = 16 * 1024 * 1024;
+
+static constexpr std::uint64_t SEQUENTIAL_READ_GAP = 64 * 1024; // a read that skips less than this is still served by the read ahead of the disk
+
+// the offsets and sizes come from the file and can be corrupt, so the end is never calculated to avoid overflowing
+static bool IsInside(std::uint64_t offset, std::uint64_t size, std::uint64_t containerSize)
+{
+	return offset <= containerSize && size <= containerSize - offset;
+}
+
+// a data block is its 64 bit uncompressed size followed by the compressed data
+static bool IsDataBlockInside(std::uint64_t offset, std::uint64_t compressedSize, std::uint64_t fileSize)
+{
+	return IsInside(offset, sizeof(std::uint64_t), fileSize) && IsInside(offset + sizeof(std::uint64_t), compressedSize, fileSize);
+}
+
+struct DataArchiveFile::EntryRecord
+{
+	std::uint64_t key = 0;
+	std::uint64_t offset = 0; // the offset of the data block from the beginning of the file
+	std::uint64_t size = 0;   // the compressed size
+	std::uint64_t uncompressedSize = 0;
+	std::uint64_t hash = 0;   // the hash of the uncompressed data
+	std::uint32_t flags = EntryFlagNone;
+	std::uint8_t codec = 0;
+	std::int8_t level = 0;
+	std::uint16_t padding = 0;
+};
+
+DataArchiveFile::DataArchiveFile(const std::string& file, OpenMethod method) : path(file), stream(file, ReadWriteFile::OpenMethod::Append)
 {
+	if (method == OpenMethod::ReadOnly)
+	{
+		mapping = std::make_unique<FileMapping>(file);
+		ReadDictionaryFromMapping();
+		return;
+	}
+
+	if (method == OpenMethod::Clear) // the stream itself never clears the file, otherwise every write session would remove the data appended before it
+	{
+		ReadWriteFile clear(file, ReadWriteFile::OpenMethod::Clear);
+		WriteSession session(clear);
+	}
+
+	stream.Open();
 	ReadDictionaryFromDisk();
 }
 
+DataArchiveFile::~DataArchiveFile()
+{
+	if (IsStreaming()) // the streamed entries are useless without a dictionary pointing to them
+		WriteToFile();
+}
+
 bool DataArchiveFile::IsValid() const
 {
-	return stream.IsValid();
+	return IsReadOnly() ? mapping->IsValid() : stream.IsValid();
+}
+
+bool DataArchiveFile::IsReadOnly() const
+{
+	return mapping != nullptr;
+}
+
+bool DataArchiveFile::HasEntry(ArchiveKey key) const
+{
+	return dictionary.contains(key.hash);
 }
 
-bool DataArchiveFile::HasEntry(const std::string& identifier) const
+void DataArchiveFile::SetStoreNames(bool store)
 {
-	return dictionary.contains(identifier);
+	storeNames = store;
+}
+
+std::string_view DataArchiveFile::GetIdentifier(ArchiveKey key)
+{
+	std::lock_guard<std::mutex> lockGuard(namesMutex);
+	LoadNames();
+
+	auto it = names.find(key.hash);
+	return it != names.end() ? std::string_view(it->second) : std::string_view();
 }
 
-void DataArchiveFile::AddData(const std::string& identifier, const std::span<char const>& data)
+DataArchiveFile::Result DataArchiveFile::AddData(std::string_view identifier, const std::span<char const>& data, CompressionCodec codec, int level)
 {
+	ArchiveKey key = identifier;
+
+	{
+		std::lock_guard<std::mutex> lockGuard(namesMutex);
+		LoadNames(); // entries from earlier sessions can only collide if their names are known, entries written without names cannot be checked
+
+		// two identifiers with the same key would overwrite each others data
+		auto it = names.find(key.hash);
+		if (it != names.end() && it->second != identifier)
+			return Result::KeyCollision;
+
+		if (it == names.end())
+			names.emplace(key.hash, identifier);
+	}
+
+	AddEntry(key.hash, data, codec, level);
+	return Result::Success;
+}
+
+void DataArchiveFile::AddEntry(std::uint64_t key, const std::span<char const>& data, CompressionCodec codec, int level)
+{
+	std::uint64_t hash = Hash::XXH64(data);
+	bool useDictionary = compressionDictionary != nullptr && codec != CompressionCodec::Store && data.size() <= DICTIONARY_THRESHOLD;
+
+	const Metadata* pExisting = FindReusableEntry(key, hash, data, codec, useDictionary);
+	if (pExisting != nullptr) // the data is already stored for this or another identifier, so it does not have to be compressed or stored again
+	{
+		Metadata& metadata = dictionary[key] = *pExisting;
+		metadata.sequence = nextSequence++;
+		return;
+	}
+
 	Metadata metadata{};
 	metadata.isOnDisk = false;
 	metadata.offset = 0; // offset is calculated when the data is written to disk
-	metadata.compressed = CompressMemory(data);
-	metadata.size = metadata.compressed.size();
+	metadata.flags = data.size() > CHUNKED_THRESHOLD && codec != CompressionCodec::Store ? EntryFlagChunked : EntryFlagNone;
+	metadata.flags |= useDictionary ? EntryFlagDictionary : EntryFlagNone;
+	metadata.codec = codec;
+	metadata.level = static_cast<std::int8_t>(level);
 	metadata.uncompressedSize = data.size();
+	metadata.hash = hash;
+	metadata.sequence = nextSequence++;
+
+	if (IsStreaming() && codec == CompressionCodec::Store) // the data can be written as is, without copying it first
+	{
+		metadata.size = data.size();
+		WriteEntryToDisk(stream, metadata, data);
+	}
+	else
+	{
+		metadata.compressed = std::make_shared<const std::vector<char>>(metadata.flags & EntryFlagChunked ? CompressChunked(data, codec, level) : CompressMemory(data, metadata.codec, level, GetCompressionDictionary(metadata)));
+		metadata.size = metadata.compressed->size();
+
+		if (metadata.codec == CompressionCodec::Store) // the data could not be compressed, not even with the dictionary
+			metadata.flags &= ~EntryFlagDictionary;
+
+		if (IsStreaming())
+		{
+			WriteEntryToDisk(stream, metadata, *metadata.compressed);
+			metadata.compressed = nullptr;
+		}
+	}
+
+	dictionary[key] = std::move(metadata);
+	contents.insert_or_assign(hash, key);
+}
+
+const DataArchiveFile::Metadata* DataArchiveFile::FindReusableEntry(std::uint64_t key, std::uint64_t hash, const std::span<char const>& data, CompressionCodec codec, bool useDictionary) const
+{
+	// data stored without compression is always reusable, otherwise data that is meant to be stored as is (for ReadView) could end up compressed
+	auto IsSameData = [&](const Metadata& metadata)
+		{
+			bool isSameCompression = metadata.codec == codec && static_cast<bool>(metadata.flags & EntryFlagDictionary) == useDictionary;
+			return metadata.hash == hash && metadata.uncompressedSize == data.size() && (isSameCompression || metadata.codec == CompressionCodec::Store) && HoldsData(metadata, data);
+		};
+
+	auto Find = [&](std::uint64_t id) -> const Metadata*
+		{
+			auto it = dictionary.find(id);
+			if (it != dictionary.end() && IsSameData(it->second))
+				return &it->second;
+
+			it = reusable.find(id);
+			if (it != reusable.end() && IsSameData(it->second))
+				return &it->second;
+
+			return nullptr;
+		};
+
+	const Metadata* pMetadata = Find(key);
+	if (pMetadata != nullptr)
+		return pMetadata;
+
+	auto it = contents.find(hash); // another identifier could be holding the same data
+	return it != contents.end() ? Find(it->second) : nullptr;
+}
 
-	dictionary[identifier] = metadata;
+// a matching hash and size are not enough to reuse an entry, two different blocks of data can still have the same hash
+bool DataArchiveFile::HoldsData(const Metadata& metadata, const std::span<char const>& data) const
+{
+	std::vector<char> stored = AcquireBuffer();
+	stored.resize(data.size());
+
+	// the cache is skipped, it finds its data by the same hash and could return the colliding data
+	bool isSame = ReadUncachedDataInto(metadata, stored) == Result::Success && std::memcmp(stored.data(), data.data(), data.size()) == 0;
+
+	ReleaseBuffer(std::move(stored));
+	return isSame;
+}
+
+std::expected<std::vector<char>, DataArchiveFile::Result> DataArchiveFile::ReadData(ArchiveKey key) const
+{
+	auto it = dictionary.find(key.hash);
+	if (it == dictionary.end())
+		return std::unexpected(Result::IdentifierNotFound);
+
+	return ReadData(it->second);
 }
 
-std::expected<std::vector<char>, DataArchiveFile::Result> DataArchiveFile::ReadData(const std::string& identifier)
+std::expected<std::vector<char>, DataArchiveFile::Result> DataArchiveFile::ReadData(const Metadata& metadata) const
 {
-	if (!dictionary.contains(identifier))
+	std::expected<std::uint64_t, Result> size = GetUncompressedSize(metadata);
+	if (!size.has_value())
+		return std::unexpected(size.error());
+
+	std::vector<char> ret(*size); // the exact size is known up front, so the data can be decompressed straight into the returned buffer
+
+	Result result = ReadDataInto(metadata, ret);
+	if (result != Result::Success)
+		return std::unexpected(result);
+
+	return ret;
+}
+
+std::expected<std::span<char>, DataArchiveFile::Result> DataArchiveFile::ReadDataInto(ArchiveKey key, const std::span<char>& dst) const
+{
+	auto it = dictionary.find(key.hash);
+	if (it == dictionary.end())
 		return std::unexpected(Result::IdentifierNotFound);
 
-	Metadata metadata = dictionary[identifier];
+	std::expected<std::uint64_t, Result> size = GetUncompressedSize(it->second);
+	if (!size.has_value())
+		return std::unexpected(size.error());
+
+	if (*size > dst.size())
+		return std::unexpected(Result::BufferTooSmall);
 
+	std::span<char> ret = dst.first(*size);
+
+	Result result = ReadDataInto(it->second, ret);
+	if (result != Result::Success)
+		return std::unexpected(result);
+
+	return ret;
+}
+
+std::expected<DataArchiveFile::PooledBuffer, DataArchiveFile::Result> DataArchiveFile::ReadDataPooled(ArchiveKey key) const
+{
+	auto it = dictionary.find(key.hash);
+	if (it == dictionary.end())
+		return std::unexpected(Result::IdentifierNotFound);
+
+	std::expected<std::uint64_t, Result> size = GetUncompressedSize(it->second);
+	if (!size.has_value())
+		return std::unexpected(size.error());
+
+	PooledBuffer buffer(*this, AcquireBuffer());
+	buffer.buffer.resize(*size);
+
+	Result result = ReadDataInto(it->second, buffer.buffer);
+	if (result != Result::Success)
+		return std::unexpected(result);
+
+	return buffer;
+}
+
+// dst must be exactly the size of the uncompressed data
+DataArchiveFile::Result DataArchiveFile::ReadDataInto(const Metadata& metadata, const std::span<char>& dst) const
+{
+	bool isCacheable = cache != nullptr && metadata.isOnDisk && metadata.hash != 0; // entries from archives that predate the footer dont have a hash to find them with
+
+	if (isCacheable)
+	{
+		std::shared_ptr<const std::vector<char>> cached = cache->Find(metadata.hash, dst.size());
+		if (cached != nullptr)
+		{
+			std::memcpy(dst.data(), cached->data(), dst.size());
+			return Result::Success;
+		}
+	}
+
+	Result result = ReadUncachedDataInto(metadata, dst);
+
+	if (isCacheable && result == Result::Success)
+		cache->Insert(metadata.hash, std::make_shared<const std::vector<char>>(dst.begin(), dst.end()));
+
+	return result;
+}
+
+DataArchiveFile::Result DataArchiveFile::ReadUncachedDataInto(const Metadata& metadata, const std::span<char>& dst) const
+{
 	if (!metadata.isOnDisk)
-		return DecompressMemory(metadata.compressed, metadata.uncompressedSize);
+		return DecompressInto(*metadata.compressed, dst, metadata.flags, metadata.codec, GetCompressionDictionary(metadata));
+
+	RecordRead(metadata);
+
+	if (IsReadOnly()) // decompress straight from the mapping, this skips opening the file and the intermediate copy
+	{
+		std::uint64_t uncompressedSize = 0;
+		std::expected<std::span<const char>, Result> compressed = GetMappedEntry(metadata, uncompressedSize);
+		if (!compressed.has_value())
+			return compressed.error();
+
+		return DecompressInto(*compressed, dst, metadata.flags, metadata.codec, GetCompressionDictionary(metadata));
+	}
+
+	if (!IsDataBlockInside(metadata.offset, metadata.size, stream.GetFileSize()))
+		return Result::InvalidReference;
+
+	return ReadFromDisk(metadata, dst);
+}
 
-	if (metadata.offset + metadata.size >= stream.GetFileSize() || metadata.offset == 0)
+void DataArchiveFile::SetCache(std::shared_ptr<ArchiveCache> cache)
+{
+	this->cache = std::move(cache);
+}
+
+std::expected<std::uint64_t, DataArchiveFile::Result> DataArchiveFile::GetUncompressedSize(ArchiveKey key) const
+{
+	auto it = dictionary.find(key.hash);
+	if (it == dictionary.end())
+		return std::unexpected(Result::IdentifierNotFound);
+
+	return GetUncompressedSize(it->second);
+}
+
+std::expected<std::uint64_t, DataArchiveFile::Result> DataArchiveFile::GetUncompressedSize(const Metadata& metadata) const
+{
+	if (!metadata.isOnDisk || metadata.hash != 0) // entries from archives that predate the footer have no hash and no uncompressed size
+		return metadata.uncompressedSize;
+
+	std::uint64_t uncompressedSize = 0; // the size has to be read from the header of the data block instead
+	bool success = IsReadOnly() ? GetMappedEntry(metadata, uncompressedSize).has_value() : stream.ReadAt(metadata.offset, reinterpret_cast<char*>(&uncompressedSize), sizeof(uncompressedSize));
+
+	if (!success)
 		return std::unexpected(Result::InvalidReference);
 
-	return ReadFromDisk(metadata.offset, metadata.size);
+	return uncompressedSize;
 }
 
-std::expected<std::vector<char>, DataArchiveFile::Result>  DataArchiveFile::ReadFromDisk(std::uint64_t offset, std::uint64_t size)
+std::expected<std::span<const char>, DataArchiveFile::Result> DataArchiveFile::ReadView(ArchiveKey key) const
 {
-	if (size == 0)
-		return std::vector<char>();
+	if (!IsReadOnly())
+		return std::unexpected(Result::NotMapped);
 
-	ReadSession session(stream);
+	auto it = dictionary.find(key.hash);
+	if (it == dictionary.end())
+		return std::unexpected(Result::IdentifierNotFound);
 
 	std::uint64_t uncompressedSize = 0;
-	stream.SeekG(offset, ReadWriteFile::Method::Begin);
-	stream.Read(reinterpret_cast<char*>(&uncompressedSize), sizeof(uncompressedSize));
+	std::expected<std::span<const char>, Result> data = GetMappedEntry(it->second, uncompressedSize);
+	if (!data.has_value())
+		return data;
+
+	RecordRead(it->second);
+
+	if (data->size() != uncompressedSize || it->second.flags & EntryFlagChunked)
+		return std::unexpected(Result::IsCompressed);
+
+	return data;
+}
 
-	std::vector<char> read(size);
-	stream.SeekG(offset + sizeof(uncompressedSize), ReadWriteFile::Method::Begin);
-	stream.Read(read.data(), static_cast<unsigned long>(size));
+std::expected<DataArchiveFile::EntryView, DataArchiveFile::Result> DataArchiveFile::ReadEntry(ArchiveKey key) const
+{
+	EntryView ret{};
+
+	std::expected<std::span<const char>, Result> view = ReadView(key);
+	if (view.has_value())
+	{
+		ret.data = *view;
+		return ret;
+	}
 
-	return DecompressMemory(read, uncompressedSize);
+	if (view.error() != Result::IsCompressed && view.error() != Result::NotMapped)
+		return std::unexpected(view.error());
+
+	std::expected<PooledBuffer, Result> data = ReadDataPooled(key);
+	if (!data.has_value())
+		return std::unexpected(data.error());
+
+	ret.storage.emplace(std::move(*data));
+	ret.data = ret.storage->GetData();
+
+	return ret;
 }
 
-std::expected<std::vector<char>, DataArchiveFile::Result> DataArchiveFile::DecompressMemory(const std::span<char const>& compressed, std::uint64_t uncompressedSize)
+// the reads are positional, so every thread of the executor can block on its own read without a platform specific asynchronous api.
+// the reads of a mapped archive are page faults instead, those are spread over the threads the same way
+void DataArchiveFile::ReadBatch(const std::span<const ArchiveKey>& keys, BatchCallback callback, const BatchExecutor& executor) const
 {
-	if (uncompressedSize == compressed.size())
-		return std::vector<char>(compressed.begin(), compressed.end());
+	std::vector<std::pair<std::uint64_t, std::size_t>> order; // the offset of the data and the index of the key
+	order.reserve(keys.size());
 
-	int bounds = LZ4_compressBound(static_cast<int>(uncompressedSize));
-	std::vector<char> uncompressed(bounds);
-	int decompressedCount = ::LZ4_decompress_safe(compressed.data(), uncompressed.data(), static_cast<int>(compressed.size()), bounds);
+	for (std::size_t i = 0; i < keys.size(); i++)
+	{
+		auto it = dictionary.find(keys[i].hash);
+		order.emplace_back(it != dictionary.end() && it->second.isOnDisk ? it->second.offset : 0, i);
+	}
+	std::sort(order.begin(), order.end());
 
-	if (decompressedCount < 0)
-		return std::unexpected(Result::DecompressionFailed); // cannot garantuee that the data inside the buffer is safe at this point
+	std::shared_ptr<const BatchCallback> shared = std::make_shared<const BatchCallback>(std::move(callback));
+
+	for (const auto& [offset, index] : order)
+	{
+		BatchRead read = [this, shared, key = keys[index], index]() { (*shared)(index, ReadEntry(key)); };
 
-	return uncompressed;
+		if (executor)
+			executor(std::move(read));
+		else
+			read();
+	}
 }
 
-std::vector<char> DataArchiveFile::CompressMemory(const std::span<char const>& uncompressed)
+std::expected<std::span<const char>, DataArchiveFile::Result> DataArchiveFile::GetMappedEntry(const Metadata& metadata, std::uint64_t& uncompressedSize) const
 {
-	std::vector<char> ret(uncompressed.size());
-	int size = static_cast<int>(uncompressed.size());
+	std::span<const char> view = mapping->GetView();
 
-	int compressedCount = LZ4_compress_default(uncompressed.data(), ret.data(), size, size);
+	if (!IsDataBlockInside(metadata.offset, metadata.size, view.size()))
+		return std::unexpected(Result::InvalidReference);
 
-	if (compressedCount == 0)
-		return std::vector<char>(uncompressed.begin(), uncompressed.end());
+	std::memcpy(&uncompressedSize, view.data() + metadata.offset, sizeof(uncompressedSize));
 
-	if (compressedCount != size)
-		ret.resize(compressedCount);
+	return view.subspan(metadata.offset + sizeof(uncompressedSize), metadata.size);
+}
+
+// every read is positional, so no shared file pointer has to be guarded and multiple threads can read at once
+DataArchiveFile::Result DataArchiveFile::ReadFromDisk(const Metadata& metadata, const std::span<char>& dst) const
+{
+	std::uint64_t dataOffset = metadata.offset + sizeof(std::uint64_t); // the size header is already known
+
+	if (metadata.size == dst.size() && !(metadata.flags & EntryFlagChunked)) // the data is stored as is, so it can be read straight into dst
+		return stream.ReadAt(dataOffset, dst.data(), dst.size()) ? Result::Success : Result::InvalidReference;
+
+	std::vector<char> compressed = AcquireBuffer();
+	compressed.resize(metadata.size);
+
+	Result result = stream.ReadAt(dataOffset, compressed.data(), compressed.size())
+		? DecompressInto(compressed, dst, metadata.flags, metadata.codec, GetCompressionDictionary(metadata))
+		: Result::InvalidReference;
+
+	ReleaseBuffer(std::move(compressed));
+	return result;
+}
+
+// reads from multiple threads are interleaved, which is counted as seeking as well since the disk has to do the same
+void DataArchiveFile::RecordRead(const Metadata& metadata) const
+{
+	std::uint64_t end = metadata.offset + sizeof(std::uint64_t) + metadata.size;
+	std::uint64_t previousEnd = lastReadEnd.exchange(end);
+
+	bool isSequential = metadata.offset >= previousEnd && metadata.offset - previousEnd <= SEQUENTIAL_READ_GAP;
+	(isSequential ? sequentialReads : randomReads)++;
+
+	bytesRead += end - metadata.offset;
+}
+
+const std::vector<std::string>& DataArchiveFile::GetCollidingIdentifiers() const
+{
+	return collidingIdentifiers;
+}
+
+DataArchiveFile::ReadStatistics DataArchiveFile::GetReadStatistics() const
+{
+	ReadStatistics ret{};
+	ret.sequentialReads = sequentialReads;
+	ret.randomReads = randomReads;
+	ret.bytesRead = bytesRead;
 
 	return ret;
 }
 
+void DataArchiveFile::ResetReadStatistics()
+{
+	lastReadEnd = 0;
+	sequentialReads = 0;
+	randomReads = 0;
+	bytesRead = 0;
+}
+
+std::vector<char> DataArchiveFile::AcquireBuffer() const
+{
+	std::lock_guard<std::mutex> lockGuard(bufferPoolMutex);
+	if (bufferPool.empty())
+		return {};
+
+	std::vector<char> ret = std::move(bufferPool.back());
+	bufferPool.pop_back();
+
+	return ret;
+}
+
+void DataArchiveFile::ReleaseBuffer(std::vector<char>&& buffer) const
+{
+	if (buffer.capacity() > MAX_POOLED_BUFFER_SIZE) // dont keep the memory of rare, huge entries around
+		return;
+
+	buffer.clear();
+
+	std::lock_guard<std::mutex> lockGuard(bufferPoolMutex);
+	if (bufferPool.size() < MAX_POOLED_BUFFER_COUNT)
+		bufferPool.push_back(std::move(buffer));
+}
+
+const CompressionDictionary* DataArchiveFile::GetCompressionDictionary() const
+{
+	return compressionDictionary.get();
+}
+
+const CompressionDictionary* DataArchiveFile::GetCompressionDictionary(const Metadata& metadata) const
+{
+	return metadata.flags & EntryFlagDictionary ? compressionDictionary.get() : nullptr;
+}
+
+DataArchiveFile::Result DataArchiveFile::DecompressInto(const std::span<char const>& compressed, const std::span<char>& dst, std::uint32_t flags, CompressionCodec codec, const CompressionDictionary* pDictionary)
+{
+	if (flags & EntryFlagChunked)
+		return DecompressChunked(compressed, dst, codec);
+
+	if (codec == CompressionCodec::Store || dst.size() == compressed.size())
+		codec = CompressionCodec::Store; // the data is stored as is
+
+	if (flags & EntryFlagDictionary && pDictionary == nullptr && codec != CompressionCodec::Store) // the archive has lost its dictionary
+		return Result::DecompressionFailed;
+
+	// cannot garantuee that the data inside the buffer is safe if this fails
+	return Compression::Decompress(compressed, dst, codec, pDictionary) ? Result::Success : Result::DecompressionFailed;
+}
+
+std::vector<char> DataArchiveFile::CompressMemory(const std::span<char const>& uncompressed, CompressionCodec& codec, int level, const CompressionDictionary* pDictionary)
+{
+	std::vector<char> ret = Compression::Compress(uncompressed, codec, level, pDictionary);
+	if (!ret.empty())
+		return ret;
+
+	codec = CompressionCodec::Store; // the data cannot be made any smaller
+	return std::vector<char>(uncompressed.begin(), uncompressed.end());
+}
+
+static std::uint32_t GetChunkCount(std::uint64_t size)
+{
+	return static_cast<std::uint32_t>((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+}
+
+static std::uint64_t GetUncompressedChunkSize(std::uint64_t totalSize, std::uint32_t chunk)
+{
+	return std::min(CHUNK_SIZE, totalSize - chunk * CHUNK_SIZE);
+}
+
+std::vector<char> DataArchiveFile::CompressChunked(const std::span<char const>& uncompressed, CompressionCodec codec, int level)
+{
+	std::uint32_t chunkCount = GetChunkCount(uncompressed.size());
+
+	std::vector<std::vector<char>> chunks(chunkCount);
+	std::vector<std::uint32_t> indices(chunkCount);
+	std::iota(indices.begin(), indices.end(), 0);
+
+	std::for_each(std::execution::par, indices.begin(), indices.end(),
+		[&](std::uint32_t i)
+		{
+			CompressionCodec chunkCodec = codec; // chunks that cannot be compressed are recognized by their size, so the codec does not have to be stored per chunk
+			chunks[i] = CompressMemory(uncompressed.subspan(i * CHUNK_SIZE, GetUncompressedChunkSize(uncompressed.size(), i)), chunkCodec, level);
+		});
+
+	std::size_t totalSize = sizeof(chunkCount) + chunkCount * sizeof(std::uint32_t);
+	for (const std::vector<char>& chunk : chunks)
+		totalSize += chunk.size();
+
+	std::vector<char> ret;
+	ret.reserve(totalSize);
+
+	auto Append = [&](const void* src, std::size_t count) { ret.insert(ret.end(), static_cast<const char*>(src), static_cast<const char*>(src) + count); };
+
+	Append(&chunkCount, sizeof(chunkCount));
+	for (const std::vector<char>& chunk : chunks)
+	{
+		std::uint32_t chunkSize = static_cast<std::uint32_t>(chunk.size());
+		Append(&chunkSize, sizeof(chunkSize));
+	}
+
+	for (const std::vector<char>& chunk : chunks)
+		Append(chunk.data(), chunk.size());
+
+	return ret;
+}
+
+DataArchiveFile::Result DataArchiveFile::DecompressChunked(const std::span<char const>& compressed, const std::span<char>& dst, CompressionCodec codec)
+{
+	std::uint64_t uncompressedSize = dst.size();
+
+	std::uint32_t chunkCount = 0;
+	if (compressed.size() < sizeof(chunkCount))
+		return Result::DecompressionFailed;
+
+	std::memcpy(&chunkCount, compressed.data(), sizeof(chunkCount));
+
+	std::size_t headerSize = sizeof(chunkCount) + chunkCount * sizeof(std::uint32_t);
+	if (chunkCount != GetChunkCount(uncompressedSize) || compressed.size() < headerSize)
+		return Result::DecompressionFailed;
+
+	std::vector<std::uint32_t> chunkSizes(chunkCount);
+	std::memcpy(chunkSizes.data(), compressed.data() + sizeof(chunkCount), chunkCount * sizeof(std::uint32_t));
+
+	std::vector<std::uint64_t> chunkOffsets(chunkCount); // the offsets of the compressed chunks
+	std::uint64_t offset = headerSize;
+	for (std::uint32_t i = 0; i < chunkCount; i++)
+	{
+		chunkOffsets[i] = offset;
+		offset += chunkSizes[i];
+	}
+
+	if (offset > compressed.size())
+		return Result::DecompressionFailed;
+
+	std::atomic<bool> failed = false;
+
+	std::vector<std::uint32_t> indices(chunkCount);
+	std::iota(indices.begin(), indices.end(), 0);
+
+	std::for_each(std::execution::par, indices.begin(), indices.end(),
+		[&](std::uint32_t i)
+		{
+			std::span<const char> src = compressed.subspan(chunkOffsets[i], chunkSizes[i]);
+			std::span<char> chunk = dst.subspan(i * CHUNK_SIZE, GetUncompressedChunkSize(uncompressedSize, i));
+
+			CompressionCodec chunkCodec = src.size() == chunk.size() ? CompressionCodec::Store : codec; // this chunk could not be compressed
+
+			if (!Compression::Decompress(src, chunk, chunkCodec))
+				failed = true;
+		});
+
+	return failed ? Result::DecompressionFailed : Result::Success;
+}
+
+static bool IsValidFooter(const Footer& footer, std::uint64_t fileSize)
+{
+	return footer.magic == ARCHIVE_MAGIC && footer.version != LEGACY_ARCHIVE_VERSION && footer.version <= ARCHIVE_VERSION && fileSize >= sizeof(Footer) && IsInside(footer.dictionaryOffset, footer.dictionarySize, fileSize - sizeof(Footer));
+}
+
 void DataArchiveFile::ReadDictionaryFromDisk()
 {
-	ReadSession session(stream);
-	stream.SeekG(0, ReadWriteFile::Method::Begin);
+	std::uint64_t fileSize = stream.GetFileSize();
+	if (fileSize < sizeof(std::uint32_t))
+		return;
+
+	Footer footer{};
+	bool hasFooter = fileSize >= sizeof(Footer) && stream.ReadAt(fileSize - sizeof(Footer), reinterpret_cast<char*>(&footer), sizeof(Footer)) && IsValidFooter(footer, fileSize);
+
+	if (!hasFooter)
+	{
+		ReadLegacyDictionaryFromDisk();
+		return;
+	}
+
+	std::vector<char> data(footer.dictionarySize); // the entire dictionary is read at once
+	if (!stream.ReadAt(footer.dictionaryOffset, data.data(), data.size()))
+		return;
+
+	ReadDictionary(data, footer.version);
+	dictionarySize = footer.dictionarySize + sizeof(Footer);
+
+	LoadCompressionDictionary();
+}
+
+// the legacy dictionary does not have its size stored anywhere, so it has to be read entry by entry
+void DataArchiveFile::ReadLegacyDictionaryFromDisk()
+{
+	std::uint64_t offset = 0;
+	namesLoaded = true; // the names are part of the legacy dictionary
+
+	auto ReadValue = [&](char* dst, std::uint64_t count)
+		{
+			bool success = stream.ReadAt(offset, dst, count);
+			offset += count;
+			return success;
+		};
 
 	uint32_t entryCount = 0;
-	bool notEOF = stream.Read(reinterpret_cast<char*>(&entryCount), sizeof(entryCount));
-	if (!notEOF)
+	if (!ReadValue(reinterpret_cast<char*>(&entryCount), sizeof(entryCount)))
 		return;
 
 	for (uint32_t i = 0; i < entryCount; i++)
@@ -127,97 +750,652 @@ void DataArchiveFile::ReadDictionaryFromDisk()
 
 		bool success = true;
 
-		success = success && stream.Read(reinterpret_cast<char*>(&stringLength), sizeof(stringLength));
+		success = success && ReadValue(reinterpret_cast<char*>(&stringLength), sizeof(stringLength));
 
 		identifier.resize(stringLength);
-		success = success && stream.Read(identifier.data(), stringLength);
-		success = success && stream.Read(reinterpret_cast<char*>(&metadata.offset), sizeof(metadata.offset));
-		success = success && stream.Read(reinterpret_cast<char*>(&metadata.size), sizeof(metadata.size));
+		success = success && ReadValue(identifier.data(), stringLength);
+		success = success && ReadValue(reinterpret_cast<char*>(&metadata.offset), sizeof(metadata.offset));
+		success = success && ReadValue(reinterpret_cast<char*>(&metadata.size), sizeof(metadata.size));
 
 		if (!success || identifier.empty())
 			return;
 
-		dictionary[identifier] = metadata;
+		AddIdentifiedEntry(std::move(identifier), metadata);
 	}
 }
 
-void DataArchiveFile::ClearDictionary()
+void DataArchiveFile::ReadDictionaryFromMapping()
 {
-	dictionary.clear();
+	if (!mapping->IsValid())
+		return;
+
+	std::span<const char> view = mapping->GetView();
+
+	Footer footer{};
+	if (view.size() >= sizeof(Footer))
+		std::memcpy(&footer, view.data() + view.size() - sizeof(Footer), sizeof(Footer));
+
+	if (view.size() >= sizeof(Footer) && IsValidFooter(footer, view.size()))
+		ReadDictionary(view.subspan(footer.dictionaryOffset, footer.dictionarySize), footer.version);
+	else
+		ReadDictionary(view, LEGACY_ARCHIVE_VERSION); // the legacy dictionary starts at the beginning of the file
+
+	LoadCompressionDictionary();
 }
 
-void DataArchiveFile::WriteToFile()
+void DataArchiveFile::LoadCompressionDictionary()
 {
-	WriteSession session(stream);
+	if (compressionDictionaryEntry.size == 0)
+		return;
 
-	WriteDictionaryToDisk();
-	WriteDataEntriesToDisk();
+	std::expected<std::vector<char>, Result> data = ReadData(compressionDictionaryEntry);
+	if (data.has_value())
+	{
+		compressionDictionaryEntry.hash = Hash::XXH64(*data);
+		compressionDictionary = std::make_unique<CompressionDictionary>(std::move(*data));
+	}
+	else
+		compressionDictionaryEntry = Metadata{}; // every entry compressed with the dictionary will fail to decompress
 }
 
-void DataArchiveFile::WriteDictionaryToDisk()
+void DataArchiveFile::SetCompressionDictionary(std::vector<char> data)
 {
-	if (!stream.IsValid())
+	if (IsReadOnly())
 		return;
 
-	std::uint64_t totalOffset = GetBinarySizeOfDictionary();
+	std::uint64_t hash = Hash::XXH64(data);
 
-	stream.SeekG(0, ReadWriteFile::Method::Begin);
+	bool isSameDictionary = compressionDictionary != nullptr ? compressionDictionaryEntry.hash == hash && compressionDictionaryEntry.size == data.size() : data.empty();
+	if (isSameDictionary) // everything compressed with the dictionary stays valid
+		return;
 
-	std::uint32_t entryCount = static_cast<std::uint32_t>(dictionary.size());
-	stream.Write(reinterpret_cast<char*>(&entryCount), sizeof(entryCount));
+	struct Recompression
+	{
+		std::uint64_t key;
+		std::vector<char> data;
+		CompressionCodec codec;
+		int level;
+	};
 
-	for (auto& [identifier, metadata] : dictionary)
+	// entries compressed with the old dictionary have to be decompressed before the dictionary is gone
+	std::vector<Recompression> recompress;
+	for (const auto& [key, metadata] : dictionary)
 	{
-		std::uint32_t stringLength = static_cast<std::uint32_t>(identifier.size());
+		if (!(metadata.flags & EntryFlagDictionary))
+			continue;
 
-		metadata.offset = totalOffset;
+		std::expected<std::vector<char>, Result> uncompressed = ReadData(metadata);
+		if (uncompressed.has_value())
+			recompress.emplace_back(key, std::move(*uncompressed), metadata.codec, metadata.level);
+	}
+
+	auto UsesDictionary = [](const auto& pair) { return static_cast<bool>(pair.second.flags & EntryFlagDictionary); };
+	std::erase_if(dictionary, UsesDictionary);
+	std::erase_if(reusable, UsesDictionary);
+
+	compressionDictionaryEntry = Metadata{};
+	compressionDictionary = nullptr;
+
+	if (!data.empty())
+	{
+		compressionDictionaryEntry.isOnDisk = false;
+		compressionDictionaryEntry.size = data.size();
+		compressionDictionaryEntry.uncompressedSize = data.size();
+		compressionDictionaryEntry.hash = hash;
+		compressionDictionaryEntry.codec = CompressionCodec::Store;
+		compressionDictionaryEntry.compressed = std::make_shared<const std::vector<char>>(data);
 
-		stream.Write(reinterpret_cast<char*>(&stringLength), sizeof(stringLength));
-		stream.Write(identifier.c_str(), static_cast<unsigned long>(identifier.size()));
-		stream.Write(reinterpret_cast<char*>(&metadata.offset), sizeof(metadata.offset));
-		stream.Write(reinterpret_cast<char*>(&metadata.size), sizeof(metadata.size));
+		if (IsStreaming())
+		{
+			WriteEntryToDisk(stream, compressionDictionaryEntry, *compressionDictionaryEntry.compressed);
+			compressionDictionaryEntry.compressed = nullptr;
+		}
 
-		totalOffset += metadata.size + sizeof(std::uint64_t); // each entry starts with an extra 64 bits !!
+		compressionDictionary = std::make_unique<CompressionDictionary>(std::move(data));
 	}
+
+	for (const Recompression& entry : recompress)
+		AddEntry(entry.key, entry.data, entry.codec, entry.level);
 }
 
-void DataArchiveFile::WriteDataEntriesToDisk()
+// the dictionary is read from memory here, so this has to check the bounds itself.
+// before version 5 the dictionary is serialized like this:
+//
+// entry count: unsigned 32 bit
+// entry count amount of entries:
+//   string, starts with a 32 bit value dictating the string length
+//   data offset from the beginning of the file: unsigned 64 bit
+//   compressed size of the data: unsigned 64 bit
+//   uncompressed size of the data: unsigned 64 bit (version 1+)
+//   hash of the uncompressed data: unsigned 64 bit (version 1+)
+//   flags describing how the data is encoded: unsigned 32 bit (version 2+)
+//   codec the data is compressed with: unsigned 8 bit (version 3+)
+//   level the data is compressed with: signed 8 bit (version 3+)
+// offset of the data block holding the compression dictionary: unsigned 64 bit (version 4+)
+// size of the compression dictionary: unsigned 64 bit, this is 0 if the archive has no compression dictionary (version 4+)
+void DataArchiveFile::ReadDictionary(const std::span<const char>& data, std::uint32_t version)
 {
-	if (!stream.IsValid())
+	if (version >= HASHED_ARCHIVE_VERSION)
+	{
+		ReadHashedDictionary(data);
+		return;
+	}
+
+	std::size_t offset = 0;
+	namesLoaded = true; // the names are part of the dictionary
+
+	auto ReadValue = [&](void* dst, std::size_t count)
+		{
+			if (offset + count > data.size())
+				return false;
+
+			std::memcpy(dst, data.data() + offset, count);
+			offset += count;
+			return true;
+		};
+
+	uint32_t entryCount = 0;
+	if (!ReadValue(&entryCount, sizeof(entryCount)))
+		return;
+
+	for (uint32_t i = 0; i < entryCount; i++)
+	{
+		std::uint32_t stringLength = 0;
+		Metadata metadata{};
+
+		if (!ReadValue(&stringLength, sizeof(stringLength)) || offset + stringLength > data.size())
+			return;
+
+		std::string identifier(data.data() + offset, stringLength);
+		offset += stringLength;
+
+		bool success = ReadValue(&metadata.offset, sizeof(metadata.offset)) && ReadValue(&metadata.size, sizeof(metadata.size));
+
+		if (version != LEGACY_ARCHIVE_VERSION)
+			success = success && ReadValue(&metadata.uncompressedSize, sizeof(metadata.uncompressedSize)) && ReadValue(&metadata.hash, sizeof(metadata.hash));
+
+		if (version >= FLAGS_ARCHIVE_VERSION)
+			success = success && ReadValue(&metadata.flags, sizeof(metadata.flags));
+
+		if (version >= CODEC_ARCHIVE_VERSION)
+			success = success && ReadValue(&metadata.codec, sizeof(metadata.codec)) && ReadValue(&metadata.level, sizeof(metadata.level)) && metadata.codec < CompressionCodec::CodecCount;
+
+		if (!success || identifier.empty())
+			return;
+
+		std::uint64_t key = ArchiveKey(identifier).hash;
+
+		if (AddIdentifiedEntry(std::move(identifier), metadata) && version != LEGACY_ARCHIVE_VERSION)
+			contents.emplace(metadata.hash, key);
+	}
+
+	if (version >= COMPRESSION_DICTIONARY_ARCHIVE_VERSION)
+	{
+		Metadata metadata{};
+		metadata.codec = CompressionCodec::Store;
+
+		if (ReadValue(&metadata.offset, sizeof(metadata.offset)) && ReadValue(&metadata.size, sizeof(metadata.size)))
+		{
+			metadata.uncompressedSize = metadata.size;
+			compressionDictionaryEntry = metadata;
+		}
+	}
+}
+
+// the dictionaries before version 5 are keyed by identifier, hashing them can give two identifiers the same key.
+// the first one is kept, just like AddData refuses the second one. the archive does not log, the caller can report the ignored identifiers
+bool DataArchiveFile::AddIdentifiedEntry(std::string identifier, const Metadata& metadata)
+{
+	ArchiveKey key = identifier;
+
+	auto it = names.find(key.hash);
+	if (it != names.end() && it->second != identifier)
+	{
+		collidingIdentifiers.push_back(std::move(identifier));
+		return false;
+	}
+
+	dictionary[key.hash] = metadata;
+	names.insert_or_assign(key.hash, std::move(identifier));
+
+	return true;
+}
+
+void DataArchiveFile::ReadHashedDictionary(const std::span<const char>& data)
+{
+	std::uint32_t entryCount = 0;
+	if (data.size() < sizeof(entryCount))
+		return;
+
+	std::memcpy(&entryCount, data.data(), sizeof(entryCount));
+
+	std::size_t recordCount = static_cast<std::size_t>(entryCount) + 2; // the entries are followed by the records of the compression dictionary and the name table
+	if (data.size() < sizeof(entryCount) + recordCount * sizeof(EntryRecord))
+		return;
+
+	std::vector<EntryRecord> records(recordCount);
+	std::memcpy(records.data(), data.data() + sizeof(entryCount), recordCount * sizeof(EntryRecord)); // the mapping gives no alignment garantuees, so the records are copied out first
+
+	dictionary.reserve(entryCount);
+	contents.reserve(entryCount);
+
+	for (std::uint32_t i = 0; i < entryCount; i++)
+	{
+		if (records[i].codec >= static_cast<std::uint8_t>(CompressionCodec::CodecCount))
+			return;
+
+		dictionary.emplace(records[i].key, FromRecord(records[i]));
+		contents.emplace(records[i].hash, records[i].key);
+	}
+
+	compressionDictionaryEntry = records[entryCount].size > 0 ? FromRecord(records[entryCount]) : Metadata{};
+	nameTableEntry = records[entryCount + 1].size > 0 ? FromRecord(records[entryCount + 1]) : Metadata{};
+}
+
+DataArchiveFile::EntryRecord DataArchiveFile::ToRecord(std::uint64_t key, const Metadata& metadata)
+{
+	static_assert(sizeof(EntryRecord) == 48, "the entry record is written to disk as is, so its layout cannot change");
+
+	EntryRecord ret{};
+	ret.key = key;
+	ret.offset = metadata.offset;
+	ret.size = metadata.size;
+	ret.uncompressedSize = metadata.uncompressedSize;
+	ret.hash = metadata.hash;
+	ret.flags = metadata.flags;
+	ret.codec = static_cast<std::uint8_t>(metadata.codec);
+	ret.level = metadata.level;
+
+	return ret;
+}
+
+DataArchiveFile::Metadata DataArchiveFile::FromRecord(const EntryRecord& record)
+{
+	Metadata ret{};
+	ret.offset = record.offset;
+	ret.size = record.size;
+	ret.uncompressedSize = record.uncompressedSize;
+	ret.hash = record.hash;
+	ret.flags = record.flags;
+	ret.codec = static_cast<CompressionCodec>(record.codec);
+	ret.level = record.level;
+
+	return ret;
+}
+
+void DataArchiveFile::LoadNames()
+{
+	if (namesLoaded)
+		return;
+
+	namesLoaded = true;
+	if (nameTableEntry.size == 0)
+		return;
+
+	std::expected<std::vector<char>, Result> data = ReadData(nameTableEntry);
+	if (!data.has_value())
+		return;
+
+	std::size_t offset = 0;
+
+	auto ReadValue = [&](void* dst, std::size_t count)
+		{
+			if (offset + count > data->size())
+				return false;
+
+			std::memcpy(dst, data->data() + offset, count);
+			offset += count;
+			return true;
+		};
+
+	std::uint32_t nameCount = 0;
+	if (!ReadValue(&nameCount, sizeof(nameCount)))
+		return;
+
+	names.reserve(names.size() + nameCount);
+
+	for (std::uint32_t i = 0; i < nameCount; i++)
+	{
+		std::uint64_t key = 0;
+		std::uint32_t stringLength = 0;
+
+		if (!ReadValue(&key, sizeof(key)) || !ReadValue(&stringLength, sizeof(stringLength)) || offset + stringLength > data->size())
+			return;
+
+		names.try_emplace(key, data->data() + offset, stringLength); // names added after opening the archive are newer
+		offset += stringLength;
+	}
+}
+
+void DataArchiveFile::UpdateNameTable()
+{
+	if (!storeNames)
+	{
+		nameTableEntry = Metadata{};
 		return;
+	}
+
+	std::lock_guard<std::mutex> lockGuard(namesMutex);
+	LoadNames(); // the names of entries that were not added again are only in the old name table
+
+	std::vector<std::uint64_t> keys;
+	keys.reserve(dictionary.size());
+
+	for (const auto& [key, metadata] : dictionary)
+		if (names.contains(key))
+			keys.push_back(key);
+
+	std::sort(keys.begin(), keys.end()); // the same names should always give the same table, so that an unchanged table is not written again
 
-	for (const auto& [identifier, metadata] : dictionary)
+	BinaryStream table;
+	table << static_cast<std::uint32_t>(keys.size());
+
+	for (std::uint64_t key : keys)
 	{
+		const std::string& name = names[key];
+		std::uint32_t stringLength = static_cast<std::uint32_t>(name.size());
+
+		table << key << stringLength;
+		table.Write(name.data(), name.size());
+	}
+
+	std::uint64_t hash = Hash::XXH64(table.data);
+	if (nameTableEntry.size > 0 && nameTableEntry.hash == hash && nameTableEntry.uncompressedSize == table.data.size())
+		return;
+
+	nameTableEntry = Metadata{};
+	nameTableEntry.isOnDisk = false;
+	nameTableEntry.uncompressedSize = table.data.size();
+	nameTableEntry.hash = hash;
+	nameTableEntry.compressed = std::make_shared<const std::vector<char>>(CompressMemory(table.data, nameTableEntry.codec, 0));
+	nameTableEntry.size = nameTableEntry.compressed->size();
+}
+
+void DataArchiveFile::ClearDictionary()
+{
+	for (const auto& [key, metadata] : dictionary)
 		if (metadata.isOnDisk)
-			continue;
+			reusable.insert_or_assign(key, metadata);
+
+	dictionary.clear();
+}
+
+void DataArchiveFile::StartStreaming()
+{
+	if (IsReadOnly() || IsStreaming())
+		return;
+
+	streamingSession = std::make_unique<WriteSession>(stream);
+	stream.SeekG(0, ReadWriteFile::Method::End);
+
+	WriteDataEntriesToDisk(stream); // the entries added before streaming have to be written as well
+}
 
-		assert(metadata.size == metadata.compressed.size());
+bool DataArchiveFile::IsStreaming() const
+{
+	return streamingSession != nullptr;
+}
 
-		stream.SeekG(static_cast<std::int64_t>(metadata.offset), ReadWriteFile::Method::Begin);
-		stream.Write(reinterpret_cast<const char*>(&metadata.uncompressedSize), sizeof(metadata.uncompressedSize));
-		stream.Write(metadata.compressed.data(), static_cast<unsigned long>(metadata.size));
+void DataArchiveFile::WriteToFile()
+{
+	if (IsReadOnly())
+		return;
+
+	UpdateNameTable();
+
+	if (IsStreaming()) // every entry is already on disk, so only the name table and the dictionary are left
+	{
+		WriteDataEntriesToDisk(stream);
+		dictionarySize = WriteDictionaryToDisk(stream, dictionary, compressionDictionaryEntry, nameTableEntry);
+		streamingSession = nullptr;
+		return;
 	}
+
+	WriteSession session(stream);
+	if (!stream.IsValid())
+		return;
+
+	stream.SeekG(0, ReadWriteFile::Method::End); // nothing on disk is overwritten, so an interrupted write still leaves the previous dictionary intact
+
+	WriteDataEntriesToDisk(stream);
+	dictionarySize = WriteDictionaryToDisk(stream, dictionary, compressionDictionaryEntry, nameTableEntry);
 }
 
-static uint64_t BinarySizeOfString(const std::string_view& str)
+void DataArchiveFile::WriteDataEntriesToDisk(const ReadWriteFile& file)
 {
-	return str.size() * sizeof(char) + sizeof(std::uint32_t);
+	std::unordered_map<const std::vector<char>*, std::uint64_t> written; // identifiers with the same data share the compressed data, which only has to be written once
+
+	auto WriteEntry = [&](Metadata& metadata)
+		{
+			if (metadata.isOnDisk)
+				return;
+
+			assert(metadata.size == metadata.compressed->size());
+
+			auto it = written.find(metadata.compressed.get());
+			if (it != written.end())
+			{
+				metadata.offset = it->second;
+				metadata.isOnDisk = true;
+				return;
+			}
+
+			WriteEntryToDisk(file, metadata, *metadata.compressed);
+			written.emplace(metadata.compressed.get(), metadata.offset);
+		};
+
+	std::vector<Metadata*> pending; // the entries are written in the order they were added, which is the order the data is expected to be read in
+	for (auto& [key, metadata] : dictionary)
+		if (!metadata.isOnDisk)
+			pending.push_back(&metadata);
+
+	std::sort(pending.begin(), pending.end(), [](const Metadata* pLhs, const Metadata* pRhs) { return pLhs->sequence < pRhs->sequence; });
+
+	WriteEntry(compressionDictionaryEntry);
+	WriteEntry(nameTableEntry);
+	for (Metadata* pMetadata : pending)
+		WriteEntry(*pMetadata);
+
+	// the data can be read back from the disk from now on
+	compressionDictionaryEntry.compressed = nullptr;
+	nameTableEntry.compressed = nullptr;
+	for (auto& [key, metadata] : dictionary)
+		metadata.compressed = nullptr;
+}
+
+void DataArchiveFile::WriteEntryToDisk(const ReadWriteFile& file, Metadata& metadata, const std::span<const char>& data) const
+{
+	metadata.offset = static_cast<std::uint64_t>(file.GetG());
+
+	file.Write(reinterpret_cast<const char*>(&metadata.uncompressedSize), sizeof(metadata.uncompressedSize));
+	file.Write(data.data(), data.size());
+
+	metadata.isOnDisk = true;
 }
 
-std::uint64_t DataArchiveFile::GetBinarySizeOfDictionary() const
+std::uint64_t DataArchiveFile::WriteDictionaryToDisk(const ReadWriteFile& file, const std::unordered_map<std::uint64_t, Metadata>& entries, const Metadata& compressionDictionaryEntry, const Metadata& nameTableEntry) const
 {
-	std::uint64_t size = sizeof(std::uint32_t);
-	for (const auto& [identifier, metadata] : dictionary)
+	std::vector<EntryRecord> records;
+	records.reserve(entries.size() + 2);
+
+	for (const auto& [key, metadata] : entries)
+		records.push_back(ToRecord(key, metadata));
+
+	std::sort(records.begin(), records.end(), [](const EntryRecord& lhs, const EntryRecord& rhs) { return lhs.key < rhs.key; });
+
+	records.push_back(ToRecord(0, compressionDictionaryEntry));
+	records.push_back(ToRecord(0, nameTableEntry));
+
+	BinaryStream data; // the dictionary is built in memory first so that it can be written in one go
+
+	std::uint32_t entryCount = static_cast<std::uint32_t>(entries.size());
+	data << entryCount;
+	data.Write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(EntryRecord));
+
+	Footer footer{};
+	footer.dictionaryOffset = static_cast<std::uint64_t>(file.GetG());
+	footer.dictionarySize = data.data.size();
+	footer.version = ARCHIVE_VERSION;
+	footer.magic = ARCHIVE_MAGIC;
+
+	file.Write(data.data.data(), data.data.size());
+	file.Write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+
+	return footer.dictionarySize + sizeof(footer);
+}
+
+void DataArchiveFile::Compact()
+{
+	if (IsReadOnly())
+		return;
+
+	WriteToFile(); // data that is only in RAM has to be on disk before it can be copied over
+
+	std::string compactPath = path + ".compact";
+	std::unordered_map<std::uint64_t, Metadata> compacted = dictionary;
+	Metadata compactedDictionaryEntry = compressionDictionaryEntry;
+	Metadata compactedNameTableEntry = nameTableEntry;
+	std::uint64_t compactedDictionarySize = 0;
+
+	bool success = true;
+	{
+		ReadWriteFile compactFile(compactPath, ReadWriteFile::OpenMethod::Clear);
+		WriteSession session(compactFile);
+
+		success = compactFile.IsValid();
+
+		std::unordered_map<std::uint64_t, std::uint64_t> copied; // maps old offsets to new offsets, data shared by multiple identifiers is only copied once
+		std::vector<char> block;
+
+		auto CopyEntry = [&](Metadata& metadata)
+			{
+				auto copiedIt = copied.find(metadata.offset);
+				if (copiedIt != copied.end())
+				{
+					metadata.offset = copiedIt->second;
+					return true;
+				}
+
+				block.resize(sizeof(std::uint64_t) + metadata.size); // the size header is copied along with the data
+				if (!stream.ReadAt(metadata.offset, block.data(), block.size()))
+					return false;
+
+				std::uint64_t newOffset = static_cast<std::uint64_t>(compactFile.GetG());
+				copied.emplace(metadata.offset, newOffset);
+
+				metadata.offset = newOffset;
+				compactFile.Write(block.data(), block.size());
+				return true;
+			};
+
+		if (compactedDictionaryEntry.size > 0)
+			success = success && CopyEntry(compactedDictionaryEntry);
+
+		if (compactedNameTableEntry.size > 0)
+			success = success && CopyEntry(compactedNameTableEntry);
+
+		// the entries are copied in the order they were added, entries from earlier sessions keep the order they already had on disk
+		std::vector<Metadata*> order;
+		order.reserve(compacted.size());
+
+		for (auto& [key, metadata] : compacted)
+			order.push_back(&metadata);
+
+		std::sort(order.begin(), order.end(), [](const Metadata* pLhs, const Metadata* pRhs) { return std::tie(pLhs->sequence, pLhs->offset) < std::tie(pRhs->sequence, pRhs->offset); });
+
+		for (auto it = order.begin(); it != order.end() && success; it++)
+			success = CopyEntry(**it);
+
+		if (success)
+			compactedDictionarySize = WriteDictionaryToDisk(compactFile, compacted, compactedDictionaryEntry, compactedNameTableEntry);
+	}
+
+	std::error_code error;
+	if (!success)
+	{
+		std::filesystem::remove(compactPath, error);
+		return;
+	}
+
+	stream.Close(); // the original file cannot be replaced while a handle to it is still open
+	std::filesystem::rename(compactPath, path, error);
+	stream.Open();
+
+	if (error)
+	{
+		std::filesystem::remove(compactPath, error);
+		return;
+	}
+
+	dictionary = std::move(compacted);
+	compressionDictionaryEntry = compactedDictionaryEntry;
+	nameTableEntry = compactedNameTableEntry;
+	dictionarySize = compactedDictionarySize;
+	reusable.clear(); // any data that isnt in the dictionary is gone now
+}
+
+std::uint64_t DataArchiveFile::GetFileSize() const
+{
+	return IsReadOnly() ? mapping->GetSize() : stream.GetFileSize();
+}
+
+std::uint64_t DataArchiveFile::GetUnusedSize() const
+{
+	std::uint64_t fileSize = GetFileSize();
+	std::uint64_t usedSize = dictionarySize;
+
+	if (compressionDictionaryEntry.isOnDisk && compressionDictionaryEntry.size > 0)
+		usedSize += sizeof(std::uint64_t) + compressionDictionaryEntry.size;
+
+	if (nameTableEntry.isOnDisk && nameTableEntry.size > 0)
+		usedSize += sizeof(std::uint64_t) + nameTableEntry.size;
+
+	std::unordered_set<std::uint64_t> offsets; // shared data should only be counted once
+	for (const auto& [key, metadata] : dictionary)
+		if (metadata.isOnDisk && offsets.insert(metadata.offset).second)
+			usedSize += sizeof(std::uint64_t) + metadata.size;
+
+	return fileSize > usedSize ? fileSize - usedSize : 0;
+}
+
+std::vector<CodecBenchmark> DataArchiveFile::BenchmarkCodecs() const
+{
+	std::vector<CodecBenchmark> results = Compression::GetBenchmarkCodecs();
+
+	for (const auto& [key, metadata] : dictionary)
 	{
-		size += BinarySizeOfString(identifier);
-		size += sizeof(metadata.offset);
-		size += sizeof(metadata.size);
+		std::expected<std::vector<char>, Result> data = ReadData(metadata);
+		if (data.has_value())
+			Compression::Benchmark(*data, results);
 	}
-	return size;
+	return results;
+}
+
+DataArchiveFile::PooledBuffer::PooledBuffer(const DataArchiveFile& parent, std::vector<char>&& buffer) : pParent(&parent), buffer(std::move(buffer))
+{
+
+}
+
+DataArchiveFile::PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept : pParent(std::exchange(other.pParent, nullptr)), buffer(std::move(other.buffer))
+{
+
+}
+
+DataArchiveFile::PooledBuffer::~PooledBuffer()
+{
+	if (pParent != nullptr)
+		pParent->ReleaseBuffer(std::move(buffer));
+}
+
+std::span<const char> DataArchiveFile::PooledBuffer::GetData() const
+{
+	return buffer;
 }
 
 DataArchiveFile::Iterator DataArchiveFile::begin()
 {
+	std::lock_guard<std::mutex> lockGuard(namesMutex);
+	LoadNames();
 	return Iterator(dictionary.begin(), *this);
 }
 
@@ -226,7 +1404,7 @@ DataArchiveFile::Iterator DataArchiveFile::end()
 	return Iterator(dictionary.end(), *this);
 }
 
-DataArchiveFile::Iterator::Iterator(const std::map<std::string, Metadata>::iterator& it, DataArchiveFile& parent) : internal(it), parent(parent)
+DataArchiveFile::Iterator::Iterator(const std::unordered_map<std::uint64_t, Metadata>::iterator& it, DataArchiveFile& parent) : internal(it), parent(parent)
 {
 
 }
@@ -238,9 +1416,12 @@ DataArchiveFile::Iterator DataArchiveFile::Iterator::operator++()
 
 DataArchiveFile::DataEntry DataArchiveFile::Iterator::operator*() const
 {
-	std::expected<std::vector<char>, Result> read = parent.ReadData(internal->first);
+	std::expected<std::vector<char>, Result> read = parent.ReadData(internal->second);
+
+	ArchiveKey key = ArchiveKey::FromHash(internal->first);
+	std::string_view identifier = parent.GetIdentifier(key);
 
-	return read.has_value() ? DataEntry{ internal->first, *read } : DataEntry{ internal->first, {} };
+	return read.has_value() ? DataEntry{ key, identifier, *read } : DataEntry{ key, identifier, {} };
 }
 
 bool DataArchiveFile::Iterator::operator!=(const Iterator& other) const
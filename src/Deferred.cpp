@@ -66,12 +66,13 @@ struct DeferredPipeline::SpatialConstants
 struct DeferredPipeline::InstanceData
 {
 	InstanceData() = default;
-	InstanceData(float u, uint32_t v, uint32_t i, uint32_t m) : uvScale(u), vertexOffset(v), indexOffset(i), material(m) {}
+	InstanceData(float u, uint32_t v, uint32_t i, uint32_t m, uint32_t s) : uvScale(u), vertexOffset(v), indexOffset(i), material(m), indexSize(s) {}
 
 	float uvScale;
 	uint32_t vertexOffset;
-	uint32_t indexOffset;
+	uint32_t indexOffset; // into index16Buffer if the index size is 16, otherwise into indexBuffer
 	int material;
+	uint32_t indexSize;
 };
 
 struct DeferredPipeline::SecondConstants
@@ -188,6 +189,7 @@ void DeferredPipeline::CreateRTGIPipeline(const Payload& payload)
 	rtgiPipeline->BindBufferToName("instanceBuffer", instanceBuffer);
 	rtgiPipeline->BindBufferToName("vertexBuffer", Renderer::g_vertexBuffer.GetBufferHandle());
 	rtgiPipeline->BindBufferToName("indexBuffer", Renderer::g_indexBuffer.GetBufferHandle());
+	rtgiPipeline->BindBufferToName("index16Buffer", Renderer::g_index16Buffer.GetBufferHandle());
 
 	rtgiPipeline->BindImageToName("transmittanceLUT", sky.GetTransmittanceView(), Renderer::defaultSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	rtgiPipeline->BindImageToName("latlongMap", sky.GetLatLongView(), Renderer::defaultSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -648,9 +650,10 @@ void DeferredPipeline::SetInstanceData(const std::vector<RenderableMesh>& meshes
 	for (const RenderableMesh& mesh : meshes)
 	{
 		uint32_t vOffset = static_cast<uint32_t>(Renderer::g_vertexBuffer.GetItemOffset(mesh.vertexMemory));
-		uint32_t iOffset = static_cast<uint32_t>(Renderer::g_indexBuffer.GetItemOffset(mesh.indexMemory));
+		uint32_t iOffset = static_cast<uint32_t>(Renderer::GetIndexOffset(mesh.indexMemory));
+		uint32_t iSize   = mesh.indexMemory.type == VK_INDEX_TYPE_UINT16 ? 16 : 32;
 
-		instances.emplace_back(mesh.uvScale, vOffset, iOffset, mesh.materialIndex);
+		instances.emplace_back(mesh.uvScale, vOffset, iOffset, mesh.materialIndex, iSize);
 	}
 	std::memcpy(instanceBuffer.GetMappedPointer(), instances.data(), sizeof(InstanceData) * instances.size());
 }
@@ -697,6 +700,7 @@ void DeferredPipeline::PerformFirstDeferred(const CommandBuffer& cmdBuffer, cons
 	glm::mat4 proj = payload.camera->GetProjectionMatrix();
 
 	bool currentlyCulling = true; // the renderer always resets the cull mode to back faced culling when a render pipeline is called
+	VkIndexType currentIndexType = VK_INDEX_TYPE_UINT32; // BindBuffersForRendering binds the 32 bit index buffer
 
 	PushConstant pushConstant{};
 	for (const RenderableMesh& mesh : meshes)
@@ -707,6 +711,12 @@ void DeferredPipeline::PerformFirstDeferred(const CommandBuffer& cmdBuffer, cons
 			cmdBuffer.SetCullMode(currentlyCulling ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE);
 		}
 
+		if (currentIndexType != mesh.indexMemory.type)
+		{
+			currentIndexType = mesh.indexMemory.type;
+			Renderer::BindIndexBuffer(cmdBuffer, currentIndexType);
+		}
+
 		glm::mat4 model = mesh.transform;
 
 		pushConstant.model = model;
@@ -811,6 +821,7 @@ void DeferredPipeline::OnRenderingBufferResize(const Payload& payload)
 {
 	rtgiPipeline->BindBufferToName("vertexBuffer", Renderer::g_vertexBuffer.GetBufferHandle());
 	rtgiPipeline->BindBufferToName("indexBuffer", Renderer::g_indexBuffer.GetBufferHandle());
+	rtgiPipeline->BindBufferToName("index16Buffer", Renderer::g_index16Buffer.GetBufferHandle());
 }
 
 void DeferredPipeline::StartSky(const Payload& payload)
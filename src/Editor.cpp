@@ -27,11 +27,16 @@ import Core.MeshObject;
 import Core.Object;
 
 import IO.SceneLoader;
+import IO.DataArchiveFile;
+import IO.Compression;
 import IO.CreationData;
+import IO.SceneStream;
+import IO.ImportCache;
 
 import System.Input;
 import System.FileDialog;
 import System.Window;
+import System.TaskGraph;
 import System;
 
 import Renderer.Gui;
@@ -50,6 +55,9 @@ constexpr float VIEWPORT_HEIGHT = 1.0f - LOWER_BAR_HEIGHT;
 
 constexpr std::string_view SUPPORTED_FILES = "*.obj;*.glb;*.gltf;*.fbx;*.stl;*.dat;";
 
+constexpr std::uint64_t ARCHIVE_CACHE_BUDGET = 512ULL * 1024 * 1024;
+constexpr std::string_view IMPORT_CACHE_DIRECTORY = "cache/imports";
+
 struct MaterialVisitor
 {
 	MaterialVisitor(int idx) : index(idx) {}
@@ -299,6 +307,12 @@ void Editor::MainThreadUpdate(float delta)
 		save = false;
 	}
 
+	if (benchmarkCodecs)
+	{
+		BenchmarkArchiveCodecs();
+		benchmarkCodecs = false;
+	}
+
 	if (!queuedMeshChange.isApplied)
 		ApplyQueuedMeshChange();
 
@@ -663,6 +677,7 @@ void Editor::ShowFileSubmenu()
 {
 	if (ImGui::MenuItem("Load file")) loadFile = true;
 	if (ImGui::MenuItem("Save file")) save = true;
+	ImGui::MenuItem("Stream loaded files", nullptr, &streamFiles);
 
 	ImGui::Separator();
 
@@ -719,6 +734,7 @@ void Editor::ShowAddSubmenu()
 
 void Editor::ShowMiscSubmenu()
 {
+	if (ImGui::MenuItem("benchmark archive codecs")) benchmarkCodecs = true;
 	if (ImGui::MenuItem("enable/disable UI"))
 	{
 		showUI = !showUI;
@@ -1183,6 +1199,8 @@ void Editor::DestroyCurrentScene()
 	for (Object* obj : objects)
 		UIFree(obj);
 
+	StreamFrom(nullptr); // a file that is still streaming in would otherwise keep adding to the cleared scene
+
 	for (int i = 1; i < Mesh::materials.size(); i++)
 		Mesh::materials[i].Destroy();
 	Mesh::materials.resize(1);
@@ -1198,20 +1216,42 @@ void Editor::LoadFile(const fs::path& path)
 {
 	Console::WriteLine("started loading {}...", Console::Severity::Debug, path.string());
 
+	if (archiveCache == nullptr)
+		archiveCache = std::make_shared<ArchiveCache>(ARCHIVE_CACHE_BUDGET);
+
+	if (importCache == nullptr)
+		importCache = std::make_shared<ImportCache>(IMPORT_CACHE_DIRECTORY);
+
+	if (streamFiles)
+	{
+		StreamFile(path);
+		return;
+	}
+
 	fut = std::async([=]()
 		{
-			SceneLoader loader(path.string());
+			SceneLoader loader(path.string(), archiveCache);
+			loader.SetImportCache(importCache);
 
 			progressBar.Start();
 			loader.LoadScene();
 
+			ArchiveCache::Statistics cacheStatistics = archiveCache->GetStatistics();
+			Console::WriteLine("archive cache: {} hits, {} misses ({:.1f}% hit rate), {} evictions, {:.1f} / {:.1f} MB used", Console::Severity::Debug, cacheStatistics.hits, cacheStatistics.misses, cacheStatistics.GetHitRate() * 100.0f, cacheStatistics.evictions, cacheStatistics.size / (1024.0 * 1024.0), cacheStatistics.budget / (1024.0 * 1024.0));
+
 			const size_t itemsToLoad = loader.objects.size() + loader.materials.size() + loader.animations.size();
 			const float progressStep = 1.0f / static_cast<float>(itemsToLoad);
 
 			Mesh::materials.resize(loader.materials.size() + 1); // resize the materials ahead of time, even if they arent loaded yet because the material indices of the meshes will be inaccurate
 
-			LoadObjectsParallel(loader.objects, progressStep);
-			LoadMaterialsParallel(loader.materials, progressStep);
+			TaskGraph uploads;
+			LoadObjectsParallel(uploads, loader.objects, progressStep);
+			LoadMaterialsParallel(uploads, loader.materials, progressStep);
+			uploads.Wait();
+
+			for (const TaskGraph::StageStatistics& stage : uploads.GetStageStatistics())
+				Console::WriteLine("loading {}: {}", Console::Severity::Debug, path.string(), stage.ToString());
+
 			LoadAnimationsParallel(loader.animations, progressStep);
 
 			progressBar.Stop();
@@ -1220,28 +1260,48 @@ void Editor::LoadFile(const fs::path& path)
 	//fut.get();
 }
 
-void Editor::LoadObjectsParallel(const std::span<const ObjectCreationData>& datas, float progressStep)
+// the file is loaded on another thread, which pushes every object and material into the stream as soon as it is read.
+// the engine adds the streamed data to the scene a bit every frame, so the editor stays responsive while a large file loads
+void Editor::StreamFile(const fs::path& path)
 {
-	std::for_each(std::execution::par_unseq, datas.begin(), datas.end(),
-		[&](const ObjectCreationData& data)
+	std::shared_ptr<SceneStream> stream = std::make_shared<SceneStream>();
+	StreamFrom(stream);
+
+	fut = std::async([=]()
 		{
-			AddObject(data);
-			progressBar.Progress(progressStep);
+			SceneLoader loader(path.string(), archiveCache);
+			loader.SetImportCache(importCache);
+			loader.StreamTo(stream);
+			loader.LoadScene();
+
+			AnimationManager* pAnimManager = HalesiaEngine::GetInstance()->GetEngineCore().animationManager;
+			for (Animation& anim : loader.animations)
+				pAnimManager->AddAnimation(std::move(anim));
 		});
 }
 
-void Editor::LoadMaterialsParallel(const std::span<const std::variant<MaterialCreationData, MaterialCreateInfo>>& datas, float progressStep)
+void Editor::LoadObjectsParallel(TaskGraph& graph, const std::span<const ObjectCreationData>& datas, float progressStep)
 {
-	std::vector<int> indices(datas.size());
-	for (int i = 0; i < indices.size(); i++)
-		indices[i] = i;
+	for (const ObjectCreationData& data : datas)
+	{
+		graph.Add("upload objects", [this, &data, progressStep]()
+			{
+				AddObject(data);
+				progressBar.Progress(progressStep);
+			});
+	}
+}
 
-	std::for_each(std::execution::par_unseq, indices.begin(), indices.end(),
-		[&](int i)
-		{
-			std::visit(MaterialVisitor(i + 1), datas[i]);
-			progressBar.Progress(progressStep);
-		});
+void Editor::LoadMaterialsParallel(TaskGraph& graph, const std::span<const std::variant<MaterialCreationData, MaterialCreateInfo>>& datas, float progressStep)
+{
+	for (int i = 0; i < static_cast<int>(datas.size()); i++)
+	{
+		graph.Add("upload materials", [this, &data = datas[i], progressStep, i]()
+			{
+				std::visit(MaterialVisitor(i + 1), data);
+				progressBar.Progress(progressStep);
+			});
+	}
 }
 
 void Editor::LoadAnimationsParallel(const std::span<Animation>& animations, float progressStep) // not actually parallel yet...
@@ -1259,6 +1319,22 @@ void Editor::BuildProject()
 	project.BuildScene(this);
 }
 
+void Editor::BenchmarkArchiveCodecs()
+{
+	const fs::path path = project.GetBuildFile();
+
+	DataArchiveFile archive(path.string(), DataArchiveFile::OpenMethod::ReadOnly);
+	if (!archive.IsValid())
+	{
+		Console::WriteLine("Cannot benchmark codecs: failed to open {}", Console::Severity::Error, path.string());
+		return;
+	}
+
+	std::vector<CodecBenchmark> results = archive.BenchmarkCodecs();
+	for (const CodecBenchmark& result : results)
+		Console::WriteLine("{} (level {}): ratio {:.3f}, compression {:.1f} MB/s, decompression {:.1f} MB/s", Console::Severity::Normal, Compression::CodecToString(result.codec), result.level, result.GetRatio(), result.GetCompressionSpeed(), result.GetDecompressionSpeed());
+}
+
 std::string Editor::GetFile(const char* desc, const char* type)
 {
 	FileDialog::Filter filter{};
@@ -0,0 +1,119 @@
+module;
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+module IO.FileMapping;
+
+import std;
+
+#ifdef _WIN32
+
+FileMapping::FileMapping(const std::string_view& file)
+{
+	std::string path = std::string(file);
+
+	HANDLE hFile = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER fileSize{};
+	if (!::GetFileSizeEx(hFile, &fileSize))
+	{
+		::CloseHandle(hFile);
+		return;
+	}
+
+	if (fileSize.QuadPart == 0) // an empty file cannot be mapped, but it is still a valid (empty) file
+	{
+		::CloseHandle(hFile);
+		valid = true;
+		return;
+	}
+
+	HANDLE hMapping = ::CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	::CloseHandle(hFile); // the mapping object keeps its own reference to the file
+
+	if (hMapping == nullptr)
+		return;
+
+	void* pView = ::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	::CloseHandle(hMapping); // the view keeps its own reference to the mapping
+
+	if (pView == nullptr)
+		return;
+
+	view = static_cast<const char*>(pView);
+	size = static_cast<std::size_t>(fileSize.QuadPart);
+	valid = true;
+}
+
+FileMapping::~FileMapping()
+{
+	if (view != nullptr)
+		::UnmapViewOfFile(view);
+}
+
+#else
+
+FileMapping::FileMapping(const std::string_view& file)
+{
+	std::string path = std::string(file);
+
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+
+	struct stat info{};
+	if (::fstat(fd, &info) != 0)
+	{
+		::close(fd);
+		return;
+	}
+
+	if (info.st_size == 0) // an empty file cannot be mapped, but it is still a valid (empty) file
+	{
+		::close(fd);
+		valid = true;
+		return;
+	}
+
+	void* pView = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping keeps its own reference to the file
+
+	if (pView == MAP_FAILED)
+		return;
+
+	view = static_cast<const char*>(pView);
+	size = static_cast<std::size_t>(info.st_size);
+	valid = true;
+}
+
+FileMapping::~FileMapping()
+{
+	if (view != nullptr)
+		::munmap(const_cast<char*>(view), size);
+}
+
+#endif
+
+bool FileMapping::IsValid() const
+{
+	return valid;
+}
+
+std::span<const char> FileMapping::GetView() const
+{
+	return std::span<const char>(view, size);
+}
+
+std::size_t FileMapping::GetSize() const
+{
+	return size;
+}
\ No newline at end of file
@@ -249,6 +249,8 @@ HalesiaEngine::ExitCode HalesiaEngine::Run()
 
 			Window::PollMessages();
 
+			core.scene->IntegrateStream(streamingBudget); // the renderer and the scripts are done with this frame, so the scene can safely be changed
+
 			if (core.renderer->CompletedFIFCyle())
 				core.scene->MainThreadUpdate(frameDelta);
 
@@ -392,6 +394,7 @@ void HalesiaEngine::RegisterConsoleVars()
 	Console::AddCVar("showFPS",      &showFPS);
 	Console::AddCVar("playFrame",    &playOneFrame);
 	Console::AddCVar("showAsync",    &showAsyncTimes);
+	Console::AddCVar("streamBudget", &streamingBudget);
 
 	Console::AddCVar("internalScale", &Renderer::internalScale);
 
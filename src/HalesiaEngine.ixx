@@ -69,6 +69,7 @@ public:
 	bool showFPS = false;                                  //!< shows the games estimated fps (1 / current_frame_time)
 	bool showAsyncTimes = false;                                  //!< shows the activity of all threads used in one frame
 	bool showWindowData = false;                                  //!< shows all data related to the games window
+	float streamingBudget = 4.0f;                                 //!< the milliseconds per frame that may be spent adding a streamed scene to the current scene
 
 private:
 	void CheckInput();                                            //!< checks for certain input needed for the engine, like if the developer console should be opened
@@ -0,0 +1,104 @@
+module IO.Hash;
+
+import std;
+
+// this follows the reference implementation of xxHash64: https://github.com/Cyan4973/xxHash
+
+static constexpr std::uint64_t PRIME_1 = 11400714785074694791ULL;
+static constexpr std::uint64_t PRIME_2 = 14029467366897019727ULL;
+static constexpr std::uint64_t PRIME_3 = 1609587929392839161ULL;
+static constexpr std::uint64_t PRIME_4 = 9650029242287828579ULL;
+static constexpr std::uint64_t PRIME_5 = 2870177450012600261ULL;
+
+static std::uint64_t Read64(const char* ptr)
+{
+	std::uint64_t ret = 0;
+	std::memcpy(&ret, ptr, sizeof(ret));
+	return ret;
+}
+
+static std::uint32_t Read32(const char* ptr)
+{
+	std::uint32_t ret = 0;
+	std::memcpy(&ret, ptr, sizeof(ret));
+	return ret;
+}
+
+static std::uint64_t Round(std::uint64_t accumulator, std::uint64_t input)
+{
+	accumulator += input * PRIME_2;
+	accumulator = std::rotl(accumulator, 31);
+	return accumulator * PRIME_1;
+}
+
+static std::uint64_t MergeRound(std::uint64_t accumulator, std::uint64_t value)
+{
+	accumulator ^= Round(0, value);
+	return accumulator * PRIME_1 + PRIME_4;
+}
+
+namespace Hash
+{
+	std::uint64_t XXH64(const std::span<const char>& data, std::uint64_t seed)
+	{
+		const char* ptr = data.data();
+		const char* end = ptr + data.size();
+
+		std::uint64_t hash = 0;
+
+		if (data.size() >= 32)
+		{
+			std::uint64_t v1 = seed + PRIME_1 + PRIME_2;
+			std::uint64_t v2 = seed + PRIME_2;
+			std::uint64_t v3 = seed;
+			std::uint64_t v4 = seed - PRIME_1;
+
+			for (; ptr + 32 <= end; ptr += 32)
+			{
+				v1 = Round(v1, Read64(ptr));
+				v2 = Round(v2, Read64(ptr + 8));
+				v3 = Round(v3, Read64(ptr + 16));
+				v4 = Round(v4, Read64(ptr + 24));
+			}
+
+			hash = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+			hash = MergeRound(hash, v1);
+			hash = MergeRound(hash, v2);
+			hash = MergeRound(hash, v3);
+			hash = MergeRound(hash, v4);
+		}
+		else
+		{
+			hash = seed + PRIME_5;
+		}
+
+		hash += static_cast<std::uint64_t>(data.size());
+
+		for (; ptr + 8 <= end; ptr += 8)
+		{
+			hash ^= Round(0, Read64(ptr));
+			hash = std::rotl(hash, 27) * PRIME_1 + PRIME_4;
+		}
+
+		if (ptr + 4 <= end)
+		{
+			hash ^= static_cast<std::uint64_t>(Read32(ptr)) * PRIME_1;
+			hash = std::rotl(hash, 23) * PRIME_2 + PRIME_3;
+			ptr += 4;
+		}
+
+		for (; ptr < end; ptr++)
+		{
+			hash ^= static_cast<std::uint64_t>(static_cast<unsigned char>(*ptr)) * PRIME_5;
+			hash = std::rotl(hash, 11) * PRIME_1;
+		}
+
+		hash ^= hash >> 33;
+		hash *= PRIME_2;
+		hash ^= hash >> 29;
+		hash *= PRIME_3;
+		hash ^= hash >> 32;
+
+		return hash;
+	}
+}
\ No newline at end of file
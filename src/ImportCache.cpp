@@ -0,0 +1,192 @@
+module;
+
+#include "core/Console.h"
+
+module IO.ImportCache;
+
+import std;
+
+import IO.CreationData;
+import IO.BinaryStream;
+import IO.FileMapping;
+import IO.Reflection;
+import IO.Hash;
+
+import Renderer.Material;
+
+// an entry is the header, followed by every material and then every base object written by the reflection layer
+struct EntryHeader
+{
+	std::uint32_t magic = 0;
+	std::uint32_t version = 0;
+	std::uint64_t contentHash = 0;
+	std::uint32_t importFlags = 0;
+	std::uint32_t materialCount = 0;
+	std::uint64_t objectCount = 0;
+	std::uint64_t rootCount = 0;
+};
+
+static_assert(sizeof(EntryHeader) == 40, "the header is written to disk as is, so its layout cannot change");
+
+constexpr std::uint32_t ENTRY_MAGIC = 0x43504D49; // "IMPC"
+constexpr std::string_view ENTRY_EXTENSION = ".import";
+
+template<> struct Reflection::Schema<MaterialCreateInfo>
+{
+	static constexpr std::uint32_t version = 0;
+	static constexpr auto fields = std::tuple
+	{
+		Field{ &MaterialCreateInfo::albedo },
+		Field{ &MaterialCreateInfo::normal },
+		Field{ &MaterialCreateInfo::metallic },
+		Field{ &MaterialCreateInfo::roughness },
+		Field{ &MaterialCreateInfo::ambientOcclusion },
+		Field{ &MaterialCreateInfo::isLight },
+	};
+};
+
+static constexpr std::array<std::string MaterialCreateInfo::*, 5> MATERIAL_TEXTURES = { &MaterialCreateInfo::albedo, &MaterialCreateInfo::normal, &MaterialCreateInfo::metallic, &MaterialCreateInfo::roughness, &MaterialCreateInfo::ambientOcclusion };
+
+std::string ImportCache::Key::ToFileName() const
+{
+	return std::format("{:016x}_{:08x}_{:08x}{}", contentHash, importFlags, version, ENTRY_EXTENSION);
+}
+
+ImportCache::ImportCache(const fs::path& directory) : directory(directory) {}
+
+std::optional<ImportCache::Key> ImportCache::CreateKey(const fs::path& source, std::uint32_t importFlags)
+{
+	FileMapping mapping(source.string());
+	if (!mapping.IsValid())
+		return std::nullopt;
+
+	Key ret{};
+	ret.contentHash = Hash::XXH64(mapping.GetView());
+	ret.importFlags = importFlags;
+	ret.version = (VERSION << 16) | CREATION_DATA_VERSION;
+
+	return ret;
+}
+
+std::optional<ImportCache::Contents> ImportCache::Find(const Key& key, const fs::path& baseDirectory) const
+{
+	fs::path path = directory / key.ToFileName();
+
+	std::error_code error;
+	if (!fs::exists(path, error))
+		return std::nullopt;
+
+	FileMapping mapping(path.string());
+	if (!mapping.IsValid() || mapping.GetSize() < sizeof(EntryHeader))
+		return std::nullopt;
+
+	std::span<const char> view = mapping.GetView();
+
+	EntryHeader header{};
+	std::memcpy(&header, view.data(), sizeof(header));
+
+	Key stored{ header.contentHash, header.importFlags, header.version };
+	if (header.magic != ENTRY_MAGIC || stored != key) // the file name already matches, but a renamed or damaged file should not be trusted
+	{
+		Console::WriteLine("the import cache entry {} does not match its name", Console::Severity::Warning, path.string());
+		return std::nullopt;
+	}
+
+	BinarySpan stream = view.subspan(sizeof(header));
+
+	Contents ret;
+	ret.objectCount = header.objectCount;
+
+	bool isValid = header.materialCount <= view.size() && header.rootCount <= view.size(); // every value takes at least a byte, so a broken count is caught before allocating
+	if (isValid)
+	{
+		ret.materials.resize(header.materialCount);
+		ret.objects.resize(header.rootCount);
+
+		isValid = std::all_of(ret.materials.begin(), ret.materials.end(), [&](MaterialCreateInfo& material) { return Reflection::Read(stream, material); })
+			&& std::all_of(ret.objects.begin(), ret.objects.end(), [&](ObjectCreationData& object) { return Reflection::Read(stream, object); });
+	}
+
+	if (!isValid)
+	{
+		Console::WriteLine("the import cache entry {} is damaged", Console::Severity::Warning, path.string());
+		return std::nullopt;
+	}
+
+	for (MaterialCreateInfo& material : ret.materials)
+		for (std::string MaterialCreateInfo::* pTexture : MATERIAL_TEXTURES)
+			if (!(material.*pTexture).empty())
+				material.*pTexture = (baseDirectory / (material.*pTexture)).string();
+
+	return ret;
+}
+
+bool ImportCache::Store(const Key& key, const std::span<const ObjectCreationData>& objects, const std::span<const MaterialCreateInfo>& materials, std::uint64_t objectCount, const fs::path& baseDirectory) const
+{
+	std::error_code error;
+	fs::create_directories(directory, error);
+
+	fs::path path = directory / key.ToFileName();
+	fs::path temporary = path;
+	temporary += ".tmp";
+
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file.good())
+		{
+			Console::WriteLine("failed to create the import cache entry {}", Console::Severity::Error, temporary.string());
+			return false;
+		}
+
+		EntryHeader header{};
+		header.magic = ENTRY_MAGIC;
+		header.version = key.version;
+		header.contentHash = key.contentHash;
+		header.importFlags = key.importFlags;
+		header.materialCount = static_cast<std::uint32_t>(materials.size());
+		header.objectCount = objectCount;
+		header.rootCount = objects.size();
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		// every value is written on its own, so that the entry never has to be held in memory as a whole
+		BinaryStream stream;
+		for (MaterialCreateInfo material : materials)
+		{
+			for (std::string MaterialCreateInfo::* pTexture : MATERIAL_TEXTURES)
+			{
+				fs::path relative = fs::path(material.*pTexture).lexically_relative(baseDirectory);
+				if (!relative.empty() && *relative.begin() != "..") // only textures next to the source file move along with it, the others keep their absolute path
+					material.*pTexture = relative.string();
+			}
+
+			stream.Clear();
+			Reflection::Write(stream, material);
+			file.write(stream.data.data(), stream.data.size());
+		}
+
+		for (const ObjectCreationData& object : objects)
+		{
+			stream.Clear();
+			Reflection::Write(stream, object);
+			file.write(stream.data.data(), stream.data.size());
+		}
+
+		if (!file.good())
+		{
+			Console::WriteLine("failed to write the import cache entry {}", Console::Severity::Error, temporary.string());
+			file.close();
+			fs::remove(temporary, error);
+			return false;
+		}
+	}
+
+	fs::rename(temporary, path, error);
+	if (error)
+	{
+		Console::WriteLine("failed to store the import cache entry {}: {}", Console::Severity::Error, path.string(), error.message());
+		fs::remove(temporary, error);
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
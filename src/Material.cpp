@@ -59,19 +59,19 @@ Material Material::Create(const MaterialCreationData& createInfo)
 
 	ret.isLight = createInfo.isLight;
 	if (!createInfo.albedo.IsDefault())      
-		ret.albedo = Texture::LoadFromInternalFormat(createInfo.albedo.data, false);
+		ret.albedo = Texture::LoadFromInternalFormat(createInfo.albedo.GetData(), false);
 
 	if (!createInfo.normal.IsDefault())      
-		ret.normal = Texture::LoadFromInternalFormat(createInfo.normal.data, false);
+		ret.normal = Texture::LoadFromInternalFormat(createInfo.normal.GetData(), false);
 
 	if (!createInfo.metallic.IsDefault())    
-		ret.metallic = Texture::LoadFromInternalFormat(createInfo.metallic.data, false);
+		ret.metallic = Texture::LoadFromInternalFormat(createInfo.metallic.GetData(), false);
 
 	if (!createInfo.roughness.IsDefault())   
-		ret.roughness = Texture::LoadFromInternalFormat(createInfo.roughness.data, false);
+		ret.roughness = Texture::LoadFromInternalFormat(createInfo.roughness.GetData(), false);
 
 	if (!createInfo.ambientOccl.IsDefault()) 
-		ret.ambientOcclusion = Texture::LoadFromInternalFormat(createInfo.ambientOccl.data, false);
+		ret.ambientOcclusion = Texture::LoadFromInternalFormat(createInfo.ambientOccl.GetData(), false);
 
 	ret.EnsurePointerSafety();
 	return ret;
@@ -4,7 +4,10 @@ module;
 
 module Renderer.Mesh;
 
+import <vulkan/vulkan.h>;
+
 import Renderer.Material;
+import Renderer.Vertex;
 import Renderer;
 
 import IO.CreationData;
@@ -14,6 +17,49 @@ import HalesiaEngine;
 std::vector<Material> Mesh::materials;
 std::mutex Mesh::materialMutex;
 
+// a serialized mesh is this header, followed by the packed vertices, the skinning data and then the indices.
+// everything after the header is a PackedMesh, which is what is uploaded to the gpu buffers
+struct MeshPayloadHeader
+{
+	std::uint32_t magic = 0;
+	std::uint32_t version = 0;
+	std::uint32_t vertexStride = 0; // the payload can only be used if this is the same as sizeof(PackedVertex)
+	std::uint32_t vertexCount = 0;
+	std::uint32_t skinningCount = 0; // either 0 or vertexCount
+	std::uint32_t indexSize = 0;     // 2 or 4 bytes
+	std::uint32_t indexCount = 0;
+	std::uint32_t materialIndex = 0;
+	std::uint32_t flags = 0;
+	float uvScale = 1.0f;
+	float boundingRadius = 0.0f; // the bounds are stored as well, so that they dont have to be calculated from every vertex again
+	std::array<float, 3> min{};
+	std::array<float, 3> max{};
+	std::array<float, 3> extents{};
+};
+static_assert(sizeof(MeshPayloadHeader) == 80);
+
+static constexpr std::uint32_t MESH_PAYLOAD_MAGIC = 0x4853454D; // "MESH"
+static constexpr std::uint32_t MESH_PAYLOAD_VERSION = 2; // version 1 stored the unpacked vertices
+
+// the payload has no alignment guarantees, so it is copied instead of viewed as T. returns the data after the copied part
+template<typename T>
+static const char* AssignFromPayload(std::vector<T>& dst, const char* src, std::size_t count)
+{
+	dst.resize(count);
+	std::memcpy(dst.data(), src, count * sizeof(T));
+
+	return src + count * sizeof(T);
+}
+
+static MeshHandle UploadGeometry(const PackedMesh& geometry)
+{
+	Renderer* renderer = HalesiaEngine::GetInstance()->GetEngineCore().renderer;
+
+	return geometry.indexType == VK_INDEX_TYPE_UINT16
+		? renderer->LoadMesh(geometry.vertices, geometry.skinning, geometry.shortIndices)
+		: renderer->LoadMesh(geometry.vertices, geometry.skinning, geometry.indices);
+}
+
 Handle Mesh::AddMaterial(const Material& material)
 {
 	std::lock_guard<std::mutex> lockGuard(materialMutex);
@@ -62,8 +108,7 @@ void Mesh::ProcessMaterial(const MaterialCreationData& creationData)
 
 void Mesh::Create(const MeshCreationData& creationData)
 {
-	vertices      = creationData.vertices;
-	indices       = creationData.indices;
+	geometry      = PackedMesh::Pack(creationData.vertices, creationData.indices);
 	faceCount     = creationData.faceCount;
 	center        = (creationData.min + creationData.max) * 0.5f;
 	extents       = creationData.max - center;
@@ -80,16 +125,99 @@ void Mesh::Create(const MeshCreationData& creationData)
 	finished = true;
 }
 
+bool Mesh::Create(const std::span<const char>& payload)
+{
+	MeshPayloadHeader header{};
+	if (payload.size() < sizeof(header))
+		return false;
+
+	std::memcpy(&header, payload.data(), sizeof(header));
+
+	std::uint64_t vertexSize = static_cast<std::uint64_t>(header.vertexCount) * sizeof(PackedVertex);
+	std::uint64_t skinningSize = static_cast<std::uint64_t>(header.skinningCount) * sizeof(SkinningData);
+	std::uint64_t indexSize = static_cast<std::uint64_t>(header.indexCount) * header.indexSize;
+
+	bool isValidHeader = header.magic == MESH_PAYLOAD_MAGIC && header.version == MESH_PAYLOAD_VERSION && header.vertexStride == sizeof(PackedVertex)
+		&& (header.skinningCount == 0 || header.skinningCount == header.vertexCount) && (header.indexSize == sizeof(std::uint16_t) || header.indexSize == sizeof(std::uint32_t));
+
+	if (!isValidHeader || payload.size() < sizeof(header) + vertexSize + skinningSize + indexSize)
+		return false;
+
+	PackedMesh loaded{};
+	loaded.indexType = header.indexSize == sizeof(std::uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+	const char* pData = payload.data() + sizeof(header);
+	pData = AssignFromPayload(loaded.vertices, pData, header.vertexCount);
+	pData = AssignFromPayload(loaded.skinning, pData, header.skinningCount);
+
+	if (loaded.indexType == VK_INDEX_TYPE_UINT16)
+		AssignFromPayload(loaded.shortIndices, pData, header.indexCount);
+	else
+		AssignFromPayload(loaded.indices, pData, header.indexCount);
+
+	geometry = std::move(loaded);
+
+	faceCount = static_cast<int>(header.indexCount / 3);
+	flags = static_cast<MeshOptionFlags>(header.flags);
+	uvScale = header.uvScale;
+
+	min = glm::vec3(header.min[0], header.min[1], header.min[2]);
+	max = glm::vec3(header.max[0], header.max[1], header.max[2]);
+	extents = glm::vec3(header.extents[0], header.extents[1], header.extents[2]);
+	center = (min + max) * 0.5f;
+	originalAABBDistance = header.boundingRadius;
+
+	SetMaterialIndex(header.materialIndex);
+
+	meshHandle = ::UploadGeometry(geometry); // the bounds are already known, so Recreate isnt needed
+	finished = true;
+
+	return true;
+}
+
+void Mesh::Serialize(BinaryStream& stream) const
+{
+	MeshPayloadHeader header{};
+	header.magic = MESH_PAYLOAD_MAGIC;
+	header.version = MESH_PAYLOAD_VERSION;
+	header.vertexStride = sizeof(PackedVertex);
+	header.vertexCount = static_cast<std::uint32_t>(geometry.vertices.size());
+	header.skinningCount = static_cast<std::uint32_t>(geometry.skinning.size());
+	header.indexSize = geometry.indexType == VK_INDEX_TYPE_UINT16 ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+	header.indexCount = static_cast<std::uint32_t>(geometry.GetIndexCount());
+	header.materialIndex = GetMaterialIndex();
+	header.flags = static_cast<std::uint32_t>(flags);
+	header.uvScale = uvScale;
+	header.boundingRadius = originalAABBDistance;
+	header.min = { min.x, min.y, min.z };
+	header.max = { max.x, max.y, max.z };
+	header.extents = { extents.x, extents.y, extents.z };
+
+	stream.Reserve(sizeof(header) + geometry.vertices.size() * sizeof(PackedVertex) + geometry.skinning.size() * sizeof(SkinningData) + geometry.GetIndexCount() * header.indexSize);
+
+	// every member of the packed types is written, they have no padding that could make identical meshes hash differently
+	stream.Write(reinterpret_cast<const char*>(&header), sizeof(header));
+	stream.WriteRange(geometry.vertices);
+	stream.WriteRange(geometry.skinning);
+
+	if (geometry.indexType == VK_INDEX_TYPE_UINT16)
+		stream.WriteRange(geometry.shortIndices);
+	else
+		stream.WriteRange(geometry.indices);
+}
+
 void Mesh::Recreate()
 {
 	//TODO: create mesh here by communicating with the renderer.
-	meshHandle = HalesiaEngine::GetInstance()->GetEngineCore().renderer->LoadMesh(vertices, indices); // this has to be the ugliest code EVER
+	meshHandle = ::UploadGeometry(geometry); // this has to be the ugliest code EVER
 
-	for (const Vertex& vertex : vertices) // better if this is precalculated
+	for (const PackedVertex& vertex : geometry.vertices) // better if this is precalculated
 	{
-		min = glm::min(vertex.position, min);
-		max = glm::max(vertex.position, max);
-		originalAABBDistance = std::max(originalAABBDistance, glm::length(vertex.position));
+		glm::vec3 position(vertex.position[0], vertex.position[1], vertex.position[2]);
+
+		min = glm::min(position, min);
+		max = glm::max(position, max);
+		originalAABBDistance = std::max(originalAABBDistance, glm::length(position));
 	}
 
 	center = (min + max) * 0.5f;
@@ -100,8 +228,7 @@ void Mesh::Recreate()
 
 void Mesh::CopyFrom(const Mesh& mesh)
 {
-	vertices = mesh.vertices;
-	indices = mesh.indices;
+	geometry = mesh.geometry;
 
 	bool succ = HalesiaEngine::GetInstance()->GetEngineCore().renderer->CopyMeshHandle(mesh.meshHandle);
 	if (!succ)
@@ -175,7 +302,7 @@ void Mesh::AwaitGeneration()
 
 bool Mesh::IsValid() const
 {
-	return !vertices.empty() && !indices.empty();
+	return !geometry.vertices.empty() && geometry.GetIndexCount() != 0;
 }
 
 bool Mesh::CanBeRayTraced() const
@@ -202,8 +329,7 @@ void Mesh::Destroy()
 		materials[materialIndex].RemoveReference();
 
 	// should also delete the material in materials here (if no other meshes are referencing that material)
-	indices.clear();
-	vertices.clear();
+	geometry = PackedMesh();
 
 
 	HalesiaEngine::GetInstance()->GetEngineCore().renderer->DestroyMeshHandle(meshHandle);
@@ -1,3 +1,7 @@
+module;
+
+#include "core/Console.h"
+
 module Core.MeshObject;
 
 import std;
@@ -50,47 +54,13 @@ void MeshObject::DuplicateDataTo(Object* pObject) const
 
 void MeshObject::SerializeSelf(BinaryStream& stream) const
 {
-	throw std::runtime_error("outdated mesh serialization");
-
-	stream << mesh.uvScale;
-	stream << mesh.GetMaterialIndex();
-
-	size_t vertexCount = mesh.vertices.size();
-	stream << vertexCount;
-	stream.Write(reinterpret_cast<const char*>(mesh.vertices.data()), vertexCount * sizeof(Vertex));
-
-	size_t indexCount = mesh.indices.size();
-	stream << indexCount;
-	stream.Write(reinterpret_cast<const char*>(mesh.indices.data()), indexCount * sizeof(uint32_t));
+	mesh.Serialize(stream);
 }
 
 void MeshObject::DeserializeSelf(const BinarySpan& stream)
 {
-	throw std::runtime_error("outdated mesh deserialization");
-
-	float uvScale = 1.0f;
-
-	MeshCreationData creationData{};
-	stream >> uvScale;
-	stream >> creationData.cullBackFaces;
-	stream >> creationData.materialIndex;
-
-	size_t vertexCount = 0;
-	stream >> vertexCount;
-
-	creationData.vertices.resize(vertexCount);
-	stream.Read(reinterpret_cast<char*>(creationData.vertices.data()), vertexCount * sizeof(Vertex));
-
-	size_t indexCount = 0;
-	stream >> indexCount;
-
-	creationData.indices.resize(indexCount);
-	stream.Read(reinterpret_cast<char*>(creationData.indices.data()), indexCount * sizeof(uint32_t));
-
-	creationData.faceCount = static_cast<int>(creationData.indices.size() / 3);
-
-	mesh.Create(creationData);
-	mesh.uvScale = uvScale;
+	if (!mesh.Create(stream.data.subspan(stream.GetOffset())))
+		Console::WriteLine("failed to deserialize the mesh of {}", Console::Severity::Error, name);
 }
 
 MeshObject::~MeshObject()
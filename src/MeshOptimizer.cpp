@@ -0,0 +1,321 @@
+module IO.MeshOptimizer;
+
+import "glm.h";
+
+import std;
+
+import IO.CreationData;
+import IO.Hash;
+
+import Renderer.Vertex;
+
+constexpr std::uint32_t NO_VERTEX = std::numeric_limits<std::uint32_t>::max();
+
+float MeshOptimizer::Statistics::GetACMR() const
+{
+	return triangleCount == 0 ? 0.0f : static_cast<float>(cacheMisses) / static_cast<float>(triangleCount);
+}
+
+float MeshOptimizer::Statistics::GetATVR() const
+{
+	return vertexCount == 0 ? 0.0f : static_cast<float>(cacheMisses) / static_cast<float>(vertexCount);
+}
+
+MeshOptimizer::Statistics& MeshOptimizer::Statistics::operator+=(const Statistics& other)
+{
+	triangleCount += other.triangleCount;
+	vertexCount += other.vertexCount;
+	cacheMisses += other.cacheMisses;
+
+	return *this;
+}
+
+MeshOptimizer::Statistics MeshOptimizer::Analyze(const std::span<const std::uint32_t>& indices, std::size_t vertexCount, std::uint32_t cacheSize)
+{
+	Statistics ret{};
+	ret.triangleCount = indices.size() / 3;
+
+	// a vertex is in the cache if it was added less than 'cacheSize' misses ago
+	std::vector<std::uint64_t> addedAt(vertexCount, 0);
+	std::vector<bool> isUsed(vertexCount, false);
+
+	for (std::uint32_t index : indices)
+	{
+		if (index >= vertexCount)
+			continue;
+
+		if (!isUsed[index])
+		{
+			isUsed[index] = true;
+			ret.vertexCount++;
+		}
+
+		if (addedAt[index] != 0 && ret.cacheMisses + 1 - addedAt[index] <= cacheSize)
+			continue;
+
+		ret.cacheMisses++;
+		addedAt[index] = ret.cacheMisses;
+	}
+	return ret;
+}
+
+// every member of the vertex as its bits, so that vertices can be compared exactly without comparing the padding between the members
+using VertexKey = std::array<std::uint32_t, 22>;
+
+static VertexKey GetVertexKey(const Vertex& vertex)
+{
+	VertexKey ret{};
+	std::size_t offset = 0;
+
+	auto append = [&](const float* pValues, std::size_t count)
+		{
+			for (std::size_t i = 0; i < count; i++)
+				ret[offset++] = std::bit_cast<std::uint32_t>(pValues[i]);
+		};
+
+	append(&vertex.position.x, 3);
+	append(&vertex.normal.x, 3);
+	append(&vertex.textureCoordinates.x, 2);
+	append(&vertex.tangent.x, 3);
+	append(&vertex.biTangent.x, 3);
+	append(vertex.boneWeights, MAX_BONES_PER_VERTEX);
+
+	for (int boneIndex : vertex.boneIndices)
+		ret[offset++] = static_cast<std::uint32_t>(boneIndex);
+
+	return ret;
+}
+
+// replaces every vertex with the first vertex that has the exact same bits
+static void WeldVertices(std::vector<std::uint32_t>& indices, const std::vector<Vertex>& vertices)
+{
+	std::vector<VertexKey> keys(vertices.size());
+	std::transform(vertices.begin(), vertices.end(), keys.begin(), GetVertexKey);
+
+	auto hash = [&](std::uint32_t index) { return static_cast<std::size_t>(Hash::XXH64(std::span(reinterpret_cast<const char*>(keys[index].data()), sizeof(VertexKey)))); };
+	auto equal = [&](std::uint32_t lhs, std::uint32_t rhs) { return keys[lhs] == keys[rhs]; };
+
+	std::unordered_map<std::uint32_t, std::uint32_t, decltype(hash), decltype(equal)> firstVertex(vertices.size(), hash, equal);
+
+	std::vector<std::uint32_t> remap(vertices.size());
+	for (std::uint32_t i = 0; i < vertices.size(); i++)
+		remap[i] = firstVertex.try_emplace(i, i).first->second;
+
+	for (std::uint32_t& index : indices)
+		index = remap[index];
+}
+
+// Tipsify: fans around a vertex that is still in the cache for as long as possible, and starts a new cluster whenever it has to jump to a vertex that is not.
+// returns the new indices, and puts the first triangle of every cluster into 'clusters'
+static std::vector<std::uint32_t> ReorderForCache(const std::vector<std::uint32_t>& indices, std::size_t vertexCount, std::uint32_t cacheSize, std::vector<std::uint32_t>& clusters)
+{
+	const std::uint32_t triangleCount = static_cast<std::uint32_t>(indices.size() / 3);
+
+	// the triangles of every vertex, stored as one array with an offset per vertex
+	std::vector<std::uint32_t> liveTriangles(vertexCount, 0);
+	for (std::uint32_t index : indices)
+		liveTriangles[index]++;
+
+	std::vector<std::uint32_t> offsets(vertexCount + 1, 0);
+	std::inclusive_scan(liveTriangles.begin(), liveTriangles.end(), offsets.begin() + 1);
+
+	std::vector<std::uint32_t> adjacency(indices.size());
+	std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (std::uint32_t i = 0; i < indices.size(); i++)
+		adjacency[fill[indices[i]]++] = i / 3;
+
+	std::vector<std::uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool> isEmitted(triangleCount, false);
+	std::vector<std::uint32_t> deadEnds;
+	std::vector<std::uint32_t> candidates;
+
+	std::vector<std::uint32_t> ret;
+	ret.reserve(indices.size());
+
+	std::uint32_t time = cacheSize + 1;
+	std::uint32_t cursor = 0; // every vertex before the cursor has no triangles left
+
+	auto skipDeadEnd = [&]() -> std::uint32_t
+		{
+			while (!deadEnds.empty())
+			{
+				std::uint32_t vertex = deadEnds.back();
+				deadEnds.pop_back();
+
+				if (liveTriangles[vertex] > 0)
+					return vertex;
+			}
+
+			for (; cursor < vertexCount; cursor++)
+				if (liveTriangles[cursor] > 0)
+					return cursor;
+
+			return NO_VERTEX;
+		};
+
+	std::uint32_t fan = skipDeadEnd();
+	if (fan != NO_VERTEX)
+		clusters.push_back(0);
+
+	while (fan != NO_VERTEX)
+	{
+		candidates.clear();
+
+		for (std::uint32_t i = offsets[fan]; i < offsets[fan + 1]; i++)
+		{
+			std::uint32_t triangle = adjacency[i];
+			if (isEmitted[triangle])
+				continue;
+
+			isEmitted[triangle] = true;
+
+			for (std::uint32_t corner = 0; corner < 3; corner++)
+			{
+				std::uint32_t vertex = indices[triangle * 3 + corner];
+				ret.push_back(vertex);
+
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+
+				if (time - cacheTime[vertex] > cacheSize)
+					cacheTime[vertex] = time++;
+			}
+		}
+
+		// the next fan is the candidate that is still in the cache and has the most triangles that can be emitted before it leaves the cache
+		std::uint32_t next = NO_VERTEX;
+		std::int64_t bestPriority = -1;
+
+		for (std::uint32_t vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0)
+				continue;
+
+			std::int64_t priority = 0;
+			if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+				priority = time - cacheTime[vertex];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+
+		if (next == NO_VERTEX) // a dead end, the cache has nothing useful anymore so the order of what follows does not matter to it
+		{
+			next = skipDeadEnd();
+			if (next != NO_VERTEX)
+				clusters.push_back(static_cast<std::uint32_t>(ret.size() / 3));
+		}
+		fan = next;
+	}
+	return ret;
+}
+
+// sorts the clusters so that those on the outside of the mesh, facing away from its center, are drawn first. those cover the most of the mesh behind them
+static std::vector<std::uint32_t> ReorderForOverdraw(const std::vector<std::uint32_t>& indices, const std::vector<Vertex>& vertices, std::vector<std::uint32_t> clusters)
+{
+	if (clusters.size() < 2)
+		return indices;
+
+	const std::uint32_t triangleCount = static_cast<std::uint32_t>(indices.size() / 3);
+	clusters.push_back(triangleCount);
+
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+
+	std::vector<glm::vec3> centers(clusters.size() - 1, glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(clusters.size() - 1, glm::vec3(0.0f));
+
+	for (std::size_t i = 0; i + 1 < clusters.size(); i++)
+	{
+		float clusterArea = 0.0f;
+		for (std::uint32_t triangle = clusters[i]; triangle < clusters[i + 1]; triangle++)
+		{
+			const glm::vec3& a = vertices[indices[triangle * 3 + 0]].position;
+			const glm::vec3& b = vertices[indices[triangle * 3 + 1]].position;
+			const glm::vec3& c = vertices[indices[triangle * 3 + 2]].position;
+
+			glm::vec3 normal = glm::cross(b - a, c - a); // its length is twice the area, so larger triangles weigh more
+			float area = glm::length(normal);
+
+			centers[i] += (a + b + c) * (area / 3.0f);
+			normals[i] += normal;
+			clusterArea += area;
+		}
+
+		meshCenter += centers[i];
+		meshArea += clusterArea;
+
+		if (clusterArea > 0.0f)
+			centers[i] /= clusterArea;
+	}
+
+	if (meshArea > 0.0f)
+		meshCenter /= meshArea;
+
+	std::vector<float> sortKeys(clusters.size() - 1);
+	for (std::size_t i = 0; i < sortKeys.size(); i++)
+	{
+		float length = glm::length(normals[i]);
+		sortKeys[i] = length > 0.0f ? glm::dot(centers[i] - meshCenter, normals[i] / length) : 0.0f;
+	}
+
+	std::vector<std::uint32_t> order(sortKeys.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](std::uint32_t lhs, std::uint32_t rhs) { return sortKeys[lhs] > sortKeys[rhs]; });
+
+	std::vector<std::uint32_t> ret;
+	ret.reserve(indices.size());
+
+	for (std::uint32_t cluster : order)
+		ret.insert(ret.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + clusters[cluster + 1] * 3);
+
+	return ret;
+}
+
+// orders the vertices by their first use, the vertices that are not used by any triangle are dropped
+static void ReorderForFetch(std::vector<std::uint32_t>& indices, std::vector<Vertex>& vertices)
+{
+	std::vector<std::uint32_t> remap(vertices.size(), NO_VERTEX);
+	std::vector<Vertex> ordered;
+	ordered.reserve(vertices.size());
+
+	for (std::uint32_t& index : indices)
+	{
+		if (remap[index] == NO_VERTEX)
+		{
+			remap[index] = static_cast<std::uint32_t>(ordered.size());
+			ordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices = std::move(ordered);
+}
+
+MeshOptimizer::Report MeshOptimizer::Optimize(MeshCreationData& mesh, std::uint32_t cacheSize)
+{
+	Report ret{};
+	ret.before = Analyze(mesh.indices, mesh.vertices.size(), cacheSize);
+
+	bool isValid = mesh.indices.size() % 3 == 0 && std::all_of(mesh.indices.begin(), mesh.indices.end(), [&](std::uint32_t index) { return index < mesh.vertices.size(); });
+	if (!isValid || mesh.indices.empty() || static_cast<std::uint64_t>(mesh.faceCount) * 3 != mesh.indices.size()) // points and lines are left alone
+	{
+		ret.after = ret.before;
+		return ret;
+	}
+
+	WeldVertices(mesh.indices, mesh.vertices);
+
+	std::vector<std::uint32_t> clusters;
+	mesh.indices = ReorderForCache(mesh.indices, mesh.vertices.size(), cacheSize, clusters);
+	mesh.indices = ReorderForOverdraw(mesh.indices, mesh.vertices, std::move(clusters));
+
+	ReorderForFetch(mesh.indices, mesh.vertices);
+
+	ret.after = Analyze(mesh.indices, mesh.vertices.size(), cacheSize);
+	return ret;
+}
\ No newline at end of file
@@ -9,6 +9,7 @@ module Core.Object;
 import std;
 
 import IO.BinaryStream;
+import IO.Reflection;
 import IO.CreationData;
 
 Object::Object(InheritType type) : type(type)
@@ -193,94 +194,51 @@ std::vector<char> Object::Serialize() const
 	return stream.data;
 }
 
+// the header is written through the first version of the creation data, which is the layout DeserializeIntoCreationData reads
 void Object::SerializeIntoStream(BinaryStream& stream) const
 {
-	SerializeHeader(stream);
-	SerializeName(stream);
-	SerializeTransform(stream);
+	ObjectCreationData header{};
+	header.type = static_cast<ObjectCreationData::Type>(type);
+	header.name = name;
+	header.position = transform.position;
+	header.scale = transform.scale;
+	header.rotation = transform.rotation;
 
+	Reflection::Write(stream, header, 0);
 	SerializeSelf(stream);
-
-	//SerializeChildren(stream);
-}
-
-void Object::SerializeHeader(BinaryStream& stream) const
-{
-	stream << static_cast<std::underlying_type_t<InheritType>>(type);
-}
-
-void Object::SerializeName(BinaryStream& stream) const
-{
-	stream << static_cast<uint32_t>(name.size());
-	for (char ch : name)
-		stream << ch;
 }
 
-void Object::SerializeTransform(BinaryStream& stream) const
+void Object::SerializeDataIntoStream(BinaryStream& stream) const
 {
-	stream << transform.position.x << transform.position.y << transform.position.z;
-	stream << transform.scale.x << transform.scale.y << transform.scale.z;
-	stream << transform.rotation.w << transform.rotation.x << transform.rotation.y << transform.rotation.z;
-}
-
-void Object::SerializeChildren(BinaryStream& stream) const
-{
-	size_t childCount = children.size();
-	stream << childCount;
-
-	for (Object* pChild : children)
-	{
-		pChild->SerializeIntoStream(stream);
-	}
+	SerializeSelf(stream);
 }
 
+// the data of the object type is read straight from the stream, without copying it into a creation data first
 void Object::Deserialize(const BinarySpan& stream)
 {
-	DeserializeName(stream);
-	DeserializeTransform(stream);
-
-	DeserializeSelf(stream);
-}
-
-void Object::DeserializeName(const BinarySpan& stream)
-{
-	uint32_t size = 0;
-	stream >> size;
+	ObjectCreationData header{};
+	if (!Reflection::Read(stream, header, 0) || header.type != static_cast<ObjectCreationData::Type>(type))
+		return;
 
-	name.resize(size);
-	for (char ch : name)
-		stream >> ch;
-}
+	name = std::move(header.name);
+	transform.position = header.position;
+	transform.scale = header.scale;
+	transform.rotation = header.rotation;
 
-void Object::DeserializeTransform(const BinarySpan& stream)
-{
-	stream >> transform.position.x >> transform.position.y >> transform.position.z;
-	stream >> transform.scale.x >> transform.scale.y >> transform.scale.z;
-	stream >> transform.rotation.w >> transform.rotation.x >> transform.rotation.y >> transform.rotation.z;
+	DeserializeSelf(stream);
 }
 
+// the objects are stored with the header of the first version of the creation data, the rest of the stream is the data of the object type
 bool Object::DeserializeIntoCreationData(const BinarySpan& stream, ObjectCreationData& ret)
 {
-	if (stream.data.size() < 4)
+	if (!Reflection::Read(stream, ret, 0))
 		return false;
 
-	InheritType type = GetInheritTypeFromStream(stream);
-	if (type == InheritType::Invalid)
+	int type = static_cast<int>(ret.type);
+	if (type < 0 || type >= static_cast<int>(InheritType::TypeCount))
 		return false;
 
-	ret.type = static_cast<ObjectCreationData::Type>(type);
-
-	uint32_t strLen = 0;
-	stream >> strLen;
-
-	ret.name.resize(strLen);
-	stream.Read(ret.name.data(), strLen);
-
-	stream >> ret.position.x >> ret.position.y >> ret.position.z;
-	stream >> ret.scale.x >> ret.scale.y >> ret.scale.z;
-	stream >> ret.rotation.w >> ret.rotation.x >> ret.rotation.y >> ret.rotation.z;
-
-	ret.unknownData = std::vector<char>(stream.data.begin() + stream.GetOffset(), stream.data.end());
+	ret.unknownData.assign(stream.data.begin() + stream.GetOffset(), stream.data.end());
 	return true;
 }
 
@@ -19,8 +19,8 @@ VkPipeline PipelineBuilder::Build()
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-	std::array<VkVertexInputAttributeDescription, 7> attributeDescriptions = Vertex::GetAttributeDescriptions();
-	VkVertexInputBindingDescription bindingDescription = Vertex::GetBindingDescription();
+	std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions = PackedVertex::GetAttributeDescriptions();
+	VkVertexInputBindingDescription bindingDescription = PackedVertex::GetBindingDescription();
 	if (!options.noVertex)
 	{
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -1,79 +1,356 @@
 module;
 
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 module IO.ReadWriteFile;
 
 import std;
 
+static constexpr std::uint64_t MAX_IO_SIZE = 1ULL << 30; // a single read or write can only handle 32 bit counts
+static constexpr std::uint64_t UNBUFFERED_ALIGNMENT = 4096; // unbuffered reads must be aligned to the sector size, this covers every common sector size
+static constexpr std::uint64_t UNBUFFERED_BLOCK_SIZE = 8ULL << 20; // the largest bounce buffer used for unaligned unbuffered reads
+
+static void* const INVALID_FILE_HANDLE = reinterpret_cast<void*>(static_cast<std::intptr_t>(-1));
+
+// the platform specific part only opens, closes and reads or writes at an offset, everything else is built on top of these.
+// every read and write returns the amount of bytes it has done or -1 on an error
+#ifdef _WIN32
+
+static void* OpenFileHandle(const std::string& file, bool clear, ReadWriteFile::AccessHint hint, bool unbuffered)
+{
+	DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED; // overlapped handles read and write at an offset, so the handle can be shared by multiple threads
+	if (hint == ReadWriteFile::AccessHint::Sequential)
+		flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+	else if (hint == ReadWriteFile::AccessHint::Random)
+		flags |= FILE_FLAG_RANDOM_ACCESS;
+
+	if (unbuffered)
+		flags |= FILE_FLAG_NO_BUFFERING;
+
+	DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE; // writes are shared so that a second handle can read while the file is being written to
+	DWORD creation = clear ? CREATE_ALWAYS : OPEN_ALWAYS;
+
+	HANDLE ret = ::CreateFileA(file.c_str(), GENERIC_READ | (unbuffered ? 0 : GENERIC_WRITE), share, nullptr, creation, flags, nullptr);
+	if (ret == INVALID_HANDLE_VALUE && ::GetLastError() == ERROR_ACCESS_DENIED && !clear) // read only files can still be read
+		ret = ::CreateFileA(file.c_str(), GENERIC_READ, share, nullptr, OPEN_EXISTING, flags, nullptr);
+
+	return ret;
+}
+
+static void CloseFileHandle(void* handle)
+{
+	::CloseHandle(handle);
+}
+
+template<typename Function>
+static std::int64_t DoOverlapped(void* handle, std::uint64_t offset, std::uint32_t size, Function&& function)
+{
+	thread_local std::unique_ptr<void, decltype(&::CloseHandle)> event(::CreateEventA(nullptr, TRUE, FALSE, nullptr), &::CloseHandle); // every thread needs its own event to wait on its own request
+
+	OVERLAPPED overlapped{};
+	overlapped.Offset = static_cast<DWORD>(offset);
+	overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+	overlapped.hEvent = event.get();
+
+	if (!function(&overlapped) && ::GetLastError() != ERROR_IO_PENDING)
+		return ::GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+
+	DWORD count = 0;
+	if (!::GetOverlappedResult(handle, &overlapped, &count, TRUE))
+		return ::GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+
+	return count;
+}
+
+static std::int64_t ReadFileAt(void* handle, std::uint64_t offset, char* dst, std::uint32_t size)
+{
+	return DoOverlapped(handle, offset, size, [&](OVERLAPPED* pOverlapped) { return ::ReadFile(handle, dst, size, nullptr, pOverlapped); });
+}
+
+static std::int64_t WriteFileAt(void* handle, std::uint64_t offset, const char* src, std::uint32_t size)
+{
+	return DoOverlapped(handle, offset, size, [&](OVERLAPPED* pOverlapped) { return ::WriteFile(handle, src, size, nullptr, pOverlapped); });
+}
+
+static std::uint64_t GetFileHandleSize(void* handle)
+{
+	LARGE_INTEGER size{};
+	return ::GetFileSizeEx(handle, &size) ? static_cast<std::uint64_t>(size.QuadPart) : 0;
+}
+
+#else
+
+// a descriptor of 0 would be a null pointer, so every descriptor is stored one higher
+static void* ToFileHandle(int fd)
+{
+	return fd < 0 ? INVALID_FILE_HANDLE : reinterpret_cast<void*>(static_cast<std::intptr_t>(fd) + 1);
+}
+
+static int ToDescriptor(void* handle)
+{
+	return static_cast<int>(reinterpret_cast<std::intptr_t>(handle) - 1);
+}
+
+static void* OpenFileHandle(const std::string& file, bool clear, ReadWriteFile::AccessHint hint, bool unbuffered)
+{
+	int flags = O_CLOEXEC | O_CREAT | (clear ? O_TRUNC : 0);
+#ifdef O_DIRECT
+	if (unbuffered)
+		flags |= O_DIRECT;
+#endif
+
+	int fd = ::open(file.c_str(), flags | (unbuffered ? O_RDONLY : O_RDWR), 0644);
+	if (fd < 0 && (errno == EACCES || errno == EROFS) && !clear) // read only files can still be read
+		fd = ::open(file.c_str(), (flags & ~O_CREAT) | O_RDONLY);
+
+	if (fd < 0)
+		return INVALID_FILE_HANDLE;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+	if (hint == ReadWriteFile::AccessHint::Sequential)
+		::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	else if (hint == ReadWriteFile::AccessHint::Random)
+		::posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+#endif
+
+	return ToFileHandle(fd);
+}
+
+static void CloseFileHandle(void* handle)
+{
+	::close(ToDescriptor(handle));
+}
+
+static std::int64_t ReadFileAt(void* handle, std::uint64_t offset, char* dst, std::uint32_t size)
+{
+	ssize_t ret = 0;
+	do
+		ret = ::pread(ToDescriptor(handle), dst, size, static_cast<off_t>(offset));
+	while (ret < 0 && errno == EINTR);
+
+	return ret;
+}
+
+static std::int64_t WriteFileAt(void* handle, std::uint64_t offset, const char* src, std::uint32_t size)
+{
+	ssize_t ret = 0;
+	do
+		ret = ::pwrite(ToDescriptor(handle), src, size, static_cast<off_t>(offset));
+	while (ret < 0 && errno == EINTR);
+
+	return ret;
+}
+
+static std::uint64_t GetFileHandleSize(void* handle)
+{
+	struct stat info{};
+	return ::fstat(ToDescriptor(handle), &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+}
+
+#endif
+
+// reads until either the count or the end of the file is reached, a single read can return less than was asked for
+static std::int64_t ReadFully(void* handle, std::uint64_t offset, char* dst, std::uint64_t count)
+{
+	std::uint64_t done = 0;
+	while (done < count)
+	{
+		std::uint32_t size = static_cast<std::uint32_t>(std::min(count - done, MAX_IO_SIZE));
+
+		std::int64_t readCount = ReadFileAt(handle, offset + done, dst + done, size);
+		if (readCount < 0)
+			return -1;
+
+		if (readCount == 0) // reached the end of the file
+			break;
+
+		done += readCount;
+	}
+	return static_cast<std::int64_t>(done);
+}
+
 void ReadWriteFile::HandleDeleter::operator()(void* ptr) const
 {
-	if (ptr != INVALID_HANDLE_VALUE)
-		::CloseHandle(ptr);
+	if (ptr != INVALID_FILE_HANDLE)
+		CloseFileHandle(ptr);
 }
 
-ReadWriteFile::ReadWriteFile(const std::string_view& file, OpenMethod method) : file(file), method(method)
+ReadWriteFile::ReadWriteFile(const std::string_view& file, OpenMethod method, AccessHint hint, bool unbuffered) : method(method), hint(hint), unbuffered(unbuffered), file(file)
 {
 
 }
 
 bool ReadWriteFile::IsValid() const
 {
-	return handle.get() != INVALID_HANDLE_VALUE;
+	return handle.get() != INVALID_FILE_HANDLE;
+}
+
+void ReadWriteFile::Open()
+{
+	if (IsOpen())
+		return;
+
+	handle.reset(OpenFileHandle(file, method == OpenMethod::Clear, hint, false));
+
+	if (unbuffered && IsOpen()) // the file already exists now, so the unbuffered handle never creates or clears it
+		unbufferedHandle.reset(OpenFileHandle(file, false, hint, true));
+}
+
+void ReadWriteFile::Close()
+{
+	unbufferedHandle.reset();
+	handle.reset();
+}
+
+bool ReadWriteFile::IsOpen() const
+{
+	return handle != nullptr && handle.get() != INVALID_FILE_HANDLE;
 }
 
 void ReadWriteFile::StartReading()
 {
-	handle.reset(::CreateFileA(this->file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, method == OpenMethod::Append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+	Open();
+	position = 0;
 }
 
 void ReadWriteFile::StopReading()
 {
-	handle.reset();
+
 }
 
 void ReadWriteFile::StartWriting()
 {
-	handle.reset(::CreateFileA(this->file.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, method == OpenMethod::Append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+	Open();
+	position = 0;
 }
 
 void ReadWriteFile::StopWriting()
 {
-	handle.reset();
+
+}
+
+bool ReadWriteFile::ReadAt(std::uint64_t offset, char* dst, std::uint64_t count) const
+{
+	if (!IsOpen())
+		return false;
+
+	if (unbufferedHandle != nullptr && unbufferedHandle.get() != INVALID_FILE_HANDLE)
+		return ReadUnbuffered(offset, dst, count);
+
+	return ReadFully(handle.get(), offset, dst, count) == static_cast<std::int64_t>(count);
 }
 
-bool ReadWriteFile::Read(char* dst, unsigned long count) const
+// unbuffered reads have to start and end on a sector and have to go into aligned memory. the requests that arent aligned
+// are read into an aligned buffer that covers every sector the request touches, and copied out of it
+bool ReadWriteFile::ReadUnbuffered(std::uint64_t offset, char* dst, std::uint64_t count) const
 {
-	DWORD readCount = 0;
-	BOOL res = ::ReadFile(handle.get(), dst, count, &readCount, nullptr);
+	bool isAligned = offset % UNBUFFERED_ALIGNMENT == 0 && count % UNBUFFERED_ALIGNMENT == 0 && reinterpret_cast<std::uintptr_t>(dst) % UNBUFFERED_ALIGNMENT == 0;
+	if (isAligned)
+		return ReadFully(unbufferedHandle.get(), offset, dst, count) == static_cast<std::int64_t>(count);
+
+	struct AlignedDeleter
+	{
+		void operator()(char* ptr) const { ::operator delete[](ptr, std::align_val_t(UNBUFFERED_ALIGNMENT)); }
+	};
+
+	std::uint64_t alignedStart = offset - offset % UNBUFFERED_ALIGNMENT;
+	std::uint64_t alignedEnd = (offset + count + UNBUFFERED_ALIGNMENT - 1) / UNBUFFERED_ALIGNMENT * UNBUFFERED_ALIGNMENT;
+	std::uint64_t blockSize = std::min(alignedEnd - alignedStart, UNBUFFERED_BLOCK_SIZE);
+
+	std::unique_ptr<char[], AlignedDeleter> block(static_cast<char*>(::operator new[](blockSize, std::align_val_t(UNBUFFERED_ALIGNMENT))));
+
+	for (std::uint64_t blockStart = alignedStart; blockStart < offset + count; blockStart += blockSize)
+	{
+		std::int64_t readCount = ReadFully(unbufferedHandle.get(), blockStart, block.get(), std::min(blockSize, alignedEnd - blockStart)); // the end of the file does not have to be aligned, so less can be read than was asked for
+		if (readCount < 0)
+			return false;
+
+		std::uint64_t copyStart = std::max(offset, blockStart);
+		std::uint64_t copyEnd = std::min(offset + count, blockStart + blockSize);
+
+		if (blockStart + readCount < copyEnd)
+			return false;
 
-	return res && readCount != 0;
+		std::memcpy(dst + (copyStart - offset), block.get() + (copyStart - blockStart), copyEnd - copyStart);
+	}
+	return true;
 }
 
-bool ReadWriteFile::Write(const char* src, unsigned long count) const
+bool ReadWriteFile::WriteAt(std::uint64_t offset, const char* src, std::uint64_t count) const
 {
-	return ::WriteFile(handle.get(), src, count, nullptr, nullptr);
+	if (!IsOpen())
+		return false;
+
+	for (std::uint64_t done = 0; done < count;)
+	{
+		std::uint32_t size = static_cast<std::uint32_t>(std::min(count - done, MAX_IO_SIZE));
+
+		std::int64_t writtenCount = WriteFileAt(handle.get(), offset + done, src + done, size);
+		if (writtenCount <= 0)
+			return false;
+
+		done += writtenCount;
+	}
+	return true;
+}
+
+bool ReadWriteFile::Read(char* dst, std::uint64_t count) const
+{
+	if (!IsOpen())
+		return false;
+
+	std::int64_t readCount = ReadFully(handle.get(), position, dst, count);
+	if (readCount <= 0)
+		return false;
+
+	position += readCount;
+	return true;
+}
+
+bool ReadWriteFile::Write(const char* src, std::uint64_t count) const
+{
+	if (!WriteAt(position, src, count))
+		return false;
+
+	position += count;
+	return true;
 }
 
-int64_t ReadWriteFile::SeekG(int64_t index, ReadWriteFile::Method method) const
+std::int64_t ReadWriteFile::SeekG(std::int64_t index, ReadWriteFile::Method method) const
 {
-	LARGE_INTEGER g{}, ret{};
-	g.QuadPart = index;
+	std::int64_t origin = 0;
+	switch (method)
+	{
+	case Method::Begin:
+		origin = 0;
+		break;
+	case Method::Current:
+		origin = static_cast<std::int64_t>(position);
+		break;
+	case Method::End:
+		origin = static_cast<std::int64_t>(GetFileSize());
+		break;
+	}
 
-	::SetFilePointerEx(handle.get(), g, &ret, static_cast<DWORD>(method));
-	return ret.QuadPart;
+	position = static_cast<std::uint64_t>(std::max<std::int64_t>(origin + index, 0));
+	return static_cast<std::int64_t>(position);
 }
 
-int64_t ReadWriteFile::GetG() const
+std::int64_t ReadWriteFile::GetG() const
 {
-	return SeekG(0, Method::Current);
+	return static_cast<std::int64_t>(position);
 }
 
-size_t ReadWriteFile::GetFileSize() const
+std::uint64_t ReadWriteFile::GetFileSize() const
 {
-	ULARGE_INTEGER size{};
-	size.LowPart = ::GetFileSize(handle.get(), &size.HighPart);
-	return size.QuadPart;
+	return IsOpen() ? GetFileHandleSize(handle.get()) : 0;
 }
 
 ReadSession::ReadSession(ReadWriteFile& file) : file(file)
@@ -82,9 +82,11 @@ struct Renderer::SceneData // if supporting vr, then turn all camera matrices in
 };
 #pragma pack(pop)
 
-StorageBuffer<Vertex>   Renderer::g_vertexBuffer;
+StorageBuffer<PackedVertex>  Renderer::g_vertexBuffer;
 StorageBuffer<std::uint32_t> Renderer::g_indexBuffer;
-StorageBuffer<Vertex>   Renderer::g_defaultVertexBuffer;
+StorageBuffer<std::uint16_t> Renderer::g_index16Buffer;
+StorageBuffer<PackedVertex>  Renderer::g_defaultVertexBuffer;
+StorageBuffer<SkinningData>  Renderer::g_skinningBuffer;
 
 VkSampler Renderer::defaultSampler  = VK_NULL_HANDLE;
 VkSampler Renderer::noFilterSampler = VK_NULL_HANDLE;
@@ -147,8 +149,10 @@ void Renderer::Destroy()
 	//delete rayTracer;
 
 	g_defaultVertexBuffer.Destroy();
+	g_skinningBuffer.Destroy();
 	g_vertexBuffer.Destroy();
 	g_indexBuffer.Destroy();
+	g_index16Buffer.Destroy();
 
 	queryPool.Destroy();
 
@@ -314,9 +318,11 @@ void Renderer::CreateGlobalBuffers()
 	const VkBufferUsageFlags rayTracingFlags = canRayTrace ?  VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : 0;
 
 	g_defaultVertexBuffer.Reserve(1024, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	g_skinningBuffer.Reserve(1024, 0);
 
 	g_vertexBuffer.Reserve(1024, rayTracingFlags | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 	g_indexBuffer.Reserve(1024,  rayTracingFlags | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+	g_index16Buffer.Reserve(1024, rayTracingFlags | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
 
 	initGlobalBuffers = true;
 }
@@ -739,7 +745,7 @@ void Renderer::RecordCommandBuffer(CommandBuffer commandBuffer, std::uint32_t im
 
 	queryPool.Reset(commandBuffer);
 
-	animationManager->ApplyAnimations(commandBuffer.Get()); // not good
+	animationManager->ApplyAnimations(commandBuffer.Get(), GetSkinnedMeshRanges()); // not good
 
 	RunRenderPipelines(commandBuffer, camera, meshes);
 
@@ -811,7 +817,7 @@ void Renderer::RunRenderPipelines(CommandBuffer commandBuffer, CameraObject* cam
 
 void Renderer::CheckForBufferResizes()
 {
-	if (!g_vertexBuffer.HasResized() && !g_defaultVertexBuffer.HasResized() && !g_indexBuffer.HasResized())
+	if (!g_vertexBuffer.HasResized() && !g_defaultVertexBuffer.HasResized() && !g_indexBuffer.HasResized() && !g_index16Buffer.HasResized())
 		return;
 
 	RenderPipeline::Payload payload = GetPipelinePayload(GetActiveCommandBuffer(), nullptr); // maybe move this inside the main render recording to allow pipelines to use that command buffer ??
@@ -831,13 +837,31 @@ void Renderer::RenderImGUI(CommandBuffer commandBuffer)
 void Renderer::BindBuffersForRendering(CommandBuffer commandBuffer)
 {
 	commandBuffer.BindVertexBuffer(g_vertexBuffer.GetBufferHandle(), 0);
-	commandBuffer.BindIndexBuffer(g_indexBuffer.GetBufferHandle(), 0, VK_INDEX_TYPE_UINT32);
+	BindIndexBuffer(commandBuffer, VK_INDEX_TYPE_UINT32);
+}
+
+void Renderer::BindIndexBuffer(CommandBuffer commandBuffer, VkIndexType indexType)
+{
+	if (indexType == VK_INDEX_TYPE_UINT16)
+		commandBuffer.BindIndexBuffer(g_index16Buffer.GetBufferHandle(), 0, VK_INDEX_TYPE_UINT16);
+	else
+		commandBuffer.BindIndexBuffer(g_indexBuffer.GetBufferHandle(), 0, VK_INDEX_TYPE_UINT32);
+}
+
+std::size_t Renderer::GetIndexOffset(IndexMemory memory)
+{
+	return memory.type == VK_INDEX_TYPE_UINT16 ? g_index16Buffer.GetItemOffset(memory.memory) : g_indexBuffer.GetItemOffset(memory.memory);
+}
+
+std::size_t Renderer::GetIndexCount(IndexMemory memory)
+{
+	return memory.type == VK_INDEX_TYPE_UINT16 ? g_index16Buffer.GetItemCount(memory.memory) : g_indexBuffer.GetItemCount(memory.memory);
 }
 
 void Renderer::RenderMesh(CommandBuffer commandBuffer, const RenderableMesh& mesh, std::uint32_t instanceCount)
 {
-	std::uint32_t indexCount    = static_cast<std::uint32_t>(g_indexBuffer.GetItemCount(mesh.indexMemory));
-	std::uint32_t firstIndex    = static_cast<std::uint32_t>(g_indexBuffer.GetItemOffset(mesh.indexMemory));
+	std::uint32_t indexCount    = static_cast<std::uint32_t>(GetIndexCount(mesh.indexMemory));
+	std::uint32_t firstIndex    = static_cast<std::uint32_t>(GetIndexOffset(mesh.indexMemory));
 	std::int32_t  vertexOffset  = static_cast<std::int32_t>(g_vertexBuffer.GetItemOffset(mesh.vertexMemory));
 	std::uint32_t firstInstance = 0;
 
@@ -997,21 +1021,52 @@ void Renderer::SubmitRecording()
 	vgm::CollectGarbage();
 }
 
-GpuMeshData::GpuMeshData(StorageBuffer<Vertex>::Memory d, StorageBuffer<Vertex>::Memory v, StorageBuffer<std::uint32_t>::Memory i, const std::shared_ptr<BottomLevelAccelerationStructure>& b) : dVertices(d), vertices(v), indices(i), BLAS(b), refCount(1)
+GpuMeshData::GpuMeshData(StorageBuffer<PackedVertex>::Memory d, StorageBuffer<SkinningData>::Memory s, StorageBuffer<PackedVertex>::Memory v, IndexMemory i, const std::shared_ptr<BottomLevelAccelerationStructure>& b) : dVertices(d), skinning(s), vertices(v), indices(i), BLAS(b), refCount(1)
 {
 
 }
 
-MeshHandle Renderer::LoadMesh(const std::span<const Vertex>& vertices, const std::span<const std::uint32_t>& indices)
+MeshHandle Renderer::LoadMesh(const std::span<const PackedVertex>& vertices, const std::span<const SkinningData>& skinning, const std::span<const std::uint16_t>& indices)
 {
 	win32::CriticalLockGuard guard(meshDataCritSection);
+	return AddMeshData(vertices, skinning, IndexMemory{ g_index16Buffer.SubmitNewData(indices), VK_INDEX_TYPE_UINT16 });
+}
+
+MeshHandle Renderer::LoadMesh(const std::span<const PackedVertex>& vertices, const std::span<const SkinningData>& skinning, const std::span<const std::uint32_t>& indices)
+{
+	win32::CriticalLockGuard guard(meshDataCritSection);
+	return AddMeshData(vertices, skinning, IndexMemory{ g_indexBuffer.SubmitNewData(indices), VK_INDEX_TYPE_UINT32 });
+}
+
+MeshHandle Renderer::AddMeshData(const std::span<const PackedVertex>& vertices, const std::span<const SkinningData>& skinning, IndexMemory indices)
+{
+	// only a skinned mesh needs its unanimated vertices, the vertices of a static mesh never change
+	StorageBuffer<PackedVertex>::Memory mdvertices = skinning.empty() ? 0 : g_defaultVertexBuffer.SubmitNewData(vertices);
+	StorageBuffer<SkinningData>::Memory mskinning  = g_skinningBuffer.SubmitNewData(skinning);
 
-	auto mdvertices = g_defaultVertexBuffer.SubmitNewData(vertices);
 	auto mvertices  = g_vertexBuffer.SubmitNewData(vertices);
-	auto mindices   = g_indexBuffer.SubmitNewData(indices);
-	auto blas       = std::make_shared<BottomLevelAccelerationStructure>(mvertices, mindices);
+	auto blas       = std::make_shared<BottomLevelAccelerationStructure>(mvertices, indices);
 
-	return meshDatas.emplace(mdvertices, mvertices, mindices, blas);
+	return meshDatas.emplace(mdvertices, mskinning, mvertices, indices, blas);
+}
+
+std::vector<SkinnedMeshRange> Renderer::GetSkinnedMeshRanges()
+{
+	win32::CriticalLockGuard guard(meshDataCritSection);
+
+	std::vector<SkinnedMeshRange> ret;
+	for (const GpuMeshData& data : meshDatas)
+	{
+		if (data.dVertices == 0)
+			continue;
+
+		SkinnedMeshRange& range = ret.emplace_back();
+		range.sourceOffset = static_cast<std::uint32_t>(g_defaultVertexBuffer.GetItemOffset(data.dVertices));
+		range.skinningOffset = static_cast<std::uint32_t>(g_skinningBuffer.GetItemOffset(data.skinning));
+		range.destinationOffset = static_cast<std::uint32_t>(g_vertexBuffer.GetItemOffset(data.vertices));
+		range.vertexCount = static_cast<std::uint32_t>(g_vertexBuffer.GetItemCount(data.vertices));
+	}
+	return ret;
 }
 
 bool Renderer::CopyMeshHandle(const MeshHandle& handle)
@@ -1042,10 +1097,14 @@ GpuMeshData::~GpuMeshData()
 {
 	if (dVertices != 0)
 		Renderer::g_defaultVertexBuffer.DestroyData(dVertices);
+	if (skinning != 0)
+		Renderer::g_skinningBuffer.DestroyData(skinning);
 	if (vertices != 0)
 		Renderer::g_vertexBuffer.DestroyData(vertices);
-	if (indices != 0)
-		Renderer::g_indexBuffer.DestroyData(indices);
+	if (indices.memory != 0 && indices.type == VK_INDEX_TYPE_UINT16)
+		Renderer::g_index16Buffer.DestroyData(indices.memory);
+	else if (indices.memory != 0)
+		Renderer::g_indexBuffer.DestroyData(indices.memory);
 }
 
 static RenderableMeshFlags TranslateMeshFlags(MeshOptionFlags flags)
@@ -1081,7 +1140,7 @@ std::optional<RenderableMesh> Renderer::GetRenderableMeshFromObject(const Object
 	mesh.vertexMemory = data.vertices;
 	mesh.indexMemory = data.indices;
 	mesh.faceCount = pMeshObject->mesh.faceCount; // these 2 could probably be removed
-	mesh.vertexCount = static_cast<std::uint32_t>(pMeshObject->mesh.vertices.size());
+	mesh.vertexCount = static_cast<std::uint32_t>(pMeshObject->mesh.geometry.vertices.size());
 	mesh.flags = TranslateMeshFlags(pMeshObject->mesh.GetFlags());
 
 	return mesh;
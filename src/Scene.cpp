@@ -16,6 +16,10 @@ import Core.Object;
 import System.Window;
 
 import IO.CreationData;
+import IO.SceneStream;
+
+import Renderer.Mesh;
+import Renderer.Material;
 
 import System.CriticalSection;
 
@@ -31,6 +35,46 @@ bool Scene::HasFinishedLoading()
 	return true;
 }
 
+void Scene::StreamFrom(std::shared_ptr<SceneStream> newStream)
+{
+	stream = std::move(newStream);
+}
+
+bool Scene::IsStreaming() const
+{
+	return stream != nullptr;
+}
+
+void Scene::IntegrateStream(float budget)
+{
+	if (stream == nullptr)
+		return;
+
+	SceneStream::Integrator integrator;
+
+	integrator.reserveMaterials = [](std::size_t count)
+		{
+			if (Mesh::materials.size() < count + 1) // resized ahead of time, because the handles of the materials point into the vector. the first material is the default material
+				Mesh::materials.resize(count + 1);
+		};
+
+	integrator.addMaterial = [](std::size_t index, SceneStream::MaterialData& data)
+		{
+			std::visit([&](const auto& createInfo) { Mesh::InsertMaterial(static_cast<int>(index + 1), Material::Create(createInfo)); }, data);
+		};
+
+	integrator.addObject = [this](ObjectCreationData& data) { AddObject(data); };
+
+	std::chrono::duration<float, std::milli> duration(budget);
+	if (!stream->Integrate(std::chrono::duration_cast<SceneStream::Clock::duration>(duration), integrator))
+		return;
+
+	SceneStream::Statistics statistics = stream->GetStatistics();
+	Console::WriteLine("streamed {} objects and {} materials over {} frames: first object after {:.1f} ms, completed after {:.1f} ms", Console::Severity::Debug, statistics.objectCount, statistics.materialCount, statistics.frameCount, statistics.timeToFirstObject, statistics.timeToComplete);
+
+	stream.reset();
+}
+
 bool Scene::NameExists(const std::string_view& str, Object* pOwner)
 {
 	win32::CriticalLockGuard guard(objectCriticalSection);
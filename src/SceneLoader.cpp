@@ -4,6 +4,8 @@ module;
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+#include <immintrin.h>
+
 #include "core/Console.h"
 
 module IO.SceneLoader;
@@ -13,24 +15,76 @@ import std;
 import IO.DataArchiveFile;
 import IO.BinaryStream;
 import IO.CreationData;
+import IO.SceneTable;
+import IO.Reflection;
+import IO.SceneStream;
+import IO.ImportCache;
+import IO.MeshOptimizer;
 
 import Core.Object;
 
-import System.CriticalSection;
+import System.TaskGraph;
 
 namespace fs = std::filesystem;
 
 constexpr std::string_view CUSTOM_FILE_EXTENSION = ".dat";
+constexpr unsigned int ASSIMP_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_OptimizeGraph | aiProcess_OptimizeMeshes;
 
-SceneLoader::SceneLoader(std::string sceneLocation) : location(sceneLocation) {}
+SceneLoader::SceneLoader(std::string sceneLocation, std::shared_ptr<ArchiveCache> cache) : location(sceneLocation), cache(std::move(cache)) {}
 
+// every stage of loading is a separate task, so reading, decoding and converting different parts of the scene overlap with each other
 void SceneLoader::LoadScene() 
 {
+	TaskGraph graph;
+
 	fs::path path = location;
-	if (path.extension() == CUSTOM_FILE_EXTENSION)
-		LoadCustomFile();
-	else
-		LoadAssimpFile();
+	try
+	{
+		if (path.extension() == CUSTOM_FILE_EXTENSION)
+			LoadCustomFile(graph);
+		else
+			LoadAssimpFile(graph);
+	}
+	catch (...)
+	{
+		if (stream != nullptr) // the scene would otherwise keep waiting for the rest of the stream
+			stream->Finish();
+		throw;
+	}
+
+	if (stream != nullptr)
+		stream->Finish();
+
+	stageStatistics = graph.GetStageStatistics();
+	for (const TaskGraph::StageStatistics& stage : stageStatistics)
+		Console::WriteLine("loading {}: {}", Console::Severity::Debug, location, stage.ToString());
+}
+
+void SceneLoader::SetImportCache(std::shared_ptr<ImportCache> newCache)
+{
+	importCache = std::move(newCache);
+}
+
+void SceneLoader::StreamTo(std::shared_ptr<SceneStream> newStream)
+{
+	stream = std::move(newStream);
+}
+
+void SceneLoader::EmitObjects(std::size_t first)
+{
+	if (stream == nullptr || first >= objects.size())
+		return;
+
+	for (auto it = objects.begin() + first; it != objects.end(); it++)
+		stream->PushObject(std::move(*it));
+
+	objects.erase(objects.begin() + first, objects.end());
+}
+
+void SceneLoader::EmitMaterial(std::size_t index)
+{
+	if (stream != nullptr)
+		stream->PushMaterial(index, std::move(materials[index])); // the slot stays, so the indices of the other materials dont change
 }
 
 static std::vector<std::string> ReadNamedReferences(const BinarySpan& data) // maybe use string_view for small performance boost ??
@@ -51,6 +105,35 @@ static std::vector<std::string> ReadNamedReferences(const BinarySpan& data) // m
 	return ret;
 }
 
+using EntryStorage = std::optional<DataArchiveFile::PooledBuffer>; // the buffers are recycled by the archive, so walking the object tree does not allocate for every entry
+
+struct LoadedEntry // an entry that is read by one task and decoded by another
+{
+	EntryStorage storage;
+	std::span<const char> data;
+};
+
+struct SharedEntry // an entry that is still used after loading, this keeps the archive and with it the mapping alive
+{
+	std::shared_ptr<DataArchiveFile> archive; // declared before the entry, so the pooled buffer is returned before the archive can be destroyed
+	DataArchiveFile::EntryView entry;
+};
+
+// reads an entry without copying it if the archive allows it, 'storage' is only used if the entry has to be decompressed
+static std::expected<std::span<const char>, DataArchiveFile::Result> ReadEntry(DataArchiveFile& file, ArchiveKey key, EntryStorage& storage)
+{
+	std::expected<std::span<const char>, DataArchiveFile::Result> view = file.ReadView(key);
+	if (view.has_value() || (view.error() != DataArchiveFile::Result::IsCompressed && view.error() != DataArchiveFile::Result::NotMapped))
+		return view;
+
+	std::expected<DataArchiveFile::PooledBuffer, DataArchiveFile::Result> data = file.ReadDataPooled(key);
+	if (!data.has_value())
+		return std::unexpected(data.error());
+
+	storage.emplace(std::move(*data));
+	return storage->GetData();
+}
+
 // the object will only be added if it can be deserialized in its entirety (children must also be valid)
 void SceneLoader::ReadFullObject(DataArchiveFile& file, const BinarySpan& data, std::vector<ObjectCreationData>& outDst)
 {
@@ -63,40 +146,159 @@ void SceneLoader::ReadFullObject(DataArchiveFile& file, const BinarySpan& data,
 
 	objectCount++;
 
-	std::string references = creationData.name + "_ref_children";
+	ArchiveKey references = ArchiveKey(creationData.name).Append("_ref_children"); // the key is hashed in place, so the identifier does not have to be built
 	if (!file.HasEntry(references)) // not an error, since its optional to have children
 	{
-		outDst.push_back(creationData);
+		outDst.push_back(std::move(creationData));
 		return;
 	}
 
-	std::expected<std::vector<char>, DataArchiveFile::Result> childRefs = file.ReadData(creationData.name + "_ref_children");
+	EntryStorage childRefsStorage;
+	std::expected<std::span<const char>, DataArchiveFile::Result> childRefs = ReadEntry(file, references, childRefsStorage);
 	if (!childRefs.has_value())
 	{
-		outDst.push_back(creationData);
 		Console::WriteLine("failed to read child references for {}", Console::Severity::Error, creationData.name);
+		outDst.push_back(std::move(creationData));
 		return;
 	}
 
 	BinarySpan asSpan = *childRefs;
 	std::vector<std::string> children = ReadNamedReferences(asSpan);
+	childRefsStorage.reset(); // the names are copied, so the buffer can already be reused by the children
 
 	creationData.children.reserve(children.size());
+	EntryStorage objectStorage;
 	for (const std::string& child : children)
 	{
-		std::expected<std::vector<char>, DataArchiveFile::Result> objectData = file.ReadData(child);
+		std::expected<std::span<const char>, DataArchiveFile::Result> objectData = ReadEntry(file, child, objectStorage);
 		if (objectData.has_value())
 			ReadFullObject(file, *objectData, creationData.children);
 		else
 			Console::WriteLine("failed to read child object \"{}\"", Console::Severity::Error, child);
 	}
 
-	outDst.push_back(creationData);
+	outDst.push_back(std::move(creationData));
+}
+
+// the records are in depth first order, so every child comes after its parent. walking the records backwards means
+// that every object already has all of its children when it is moved into its parent, so no recursion is needed
+void SceneLoader::LoadObjectsFromTable(DataArchiveFile& file, const std::span<const char>& table)
+{
+	// the offsets and sizes come from the file, so adding them together could overflow
+	auto IsInside = [](std::uint64_t offset, std::uint64_t size, std::uint64_t containerSize) { return offset <= containerSize && size <= containerSize - offset; };
+
+	SceneTable::Header header{};
+	if (table.size() >= sizeof(header))
+		std::memcpy(&header, table.data(), sizeof(header));
+
+	std::uint64_t recordsSize = static_cast<std::uint64_t>(header.recordCount) * sizeof(SceneTable::Record); // the count is 32 bits, so this cannot overflow
+	bool isValidHeader = table.size() >= sizeof(header) && header.version != 0 && header.version <= SceneTable::VERSION;
+
+	if (!isValidHeader || !IsInside(sizeof(header), recordsSize, table.size()) || !IsInside(sizeof(header) + recordsSize, header.blobSize, table.size()))
+	{
+		Console::WriteLine("invalid scene table in {}", Console::Severity::Error, location);
+		return;
+	}
+
+	std::vector<SceneTable::Record> records(header.recordCount);
+	std::memcpy(records.data(), table.data() + sizeof(header), recordsSize);
+
+	std::span<const char> blob = table.subspan(sizeof(header) + recordsSize, header.blobSize);
+
+	std::vector<ObjectCreationData> nodes(records.size());
+	std::vector<std::uint32_t> childCounts(records.size());
+	std::vector<std::uint32_t> external; // the records whose data is in its own entry
+	std::size_t rootCount = 0;
+
+	for (std::uint32_t i = 0; i < records.size(); i++)
+	{
+		const SceneTable::Record& record = records[i];
+
+		bool isValid = (record.parent == SceneTable::NO_PARENT || record.parent < i) && record.type >= 0 && record.type < static_cast<std::int32_t>(Object::InheritType::TypeCount)
+			&& IsInside(record.nameOffset, record.nameLength, blob.size()) && (record.flags & SceneTable::RecordFlagExternalPayload || IsInside(record.payload, record.payloadSize, blob.size()));
+
+		if (!isValid) // the parent and child indices could point anywhere, so the entire table is rejected
+		{
+			Console::WriteLine("invalid object record {} in the scene table of {}", Console::Severity::Error, i, location);
+			return;
+		}
+
+		ObjectCreationData& creationData = nodes[i];
+		creationData.type = static_cast<ObjectCreationData::Type>(record.type);
+		creationData.name = std::string(blob.data() + record.nameOffset, record.nameLength);
+
+		creationData.position = glm::vec3(record.position[0], record.position[1], record.position[2]);
+		creationData.scale = glm::vec3(record.scale[0], record.scale[1], record.scale[2]);
+		creationData.rotation = glm::quat(record.rotation[0], record.rotation[1], record.rotation[2], record.rotation[3]);
+
+		if (record.flags & SceneTable::RecordFlagExternalPayload)
+			external.push_back(i);
+		else
+			creationData.unknownData = std::vector<char>(blob.data() + record.payload, blob.data() + record.payload + record.payloadSize);
+
+		if (record.parent == SceneTable::NO_PARENT)
+			rootCount++;
+		else
+			childCounts[record.parent]++;
+	}
+
+	// every read is positional, so the entries can be read and decompressed in parallel
+	std::for_each(std::execution::par, external.begin(), external.end(),
+		[&](std::uint32_t i)
+		{
+			std::expected<std::vector<char>, DataArchiveFile::Result> payload = file.ReadData(ArchiveKey::FromHash(records[i].payload));
+			if (payload.has_value())
+				nodes[i].unknownData = std::move(*payload);
+			else
+				Console::WriteLine("failed to read the data of object \"{}\"", Console::Severity::Error, nodes[i].name);
+		}
+	);
+
+	for (std::uint32_t i = 0; i < records.size(); i++)
+		nodes[i].children.reserve(childCounts[i]);
+
+	std::size_t firstRoot = objects.size();
+	objects.reserve(objects.size() + rootCount);
+
+	for (std::uint32_t i = static_cast<std::uint32_t>(records.size()); i-- > 0;)
+	{
+		std::reverse(nodes[i].children.begin(), nodes[i].children.end()); // the children were added back to front
+
+		std::vector<ObjectCreationData>& parent = records[i].parent == SceneTable::NO_PARENT ? objects : nodes[records[i].parent].children;
+		parent.push_back(std::move(nodes[i]));
+	}
+
+	std::reverse(objects.begin() + firstRoot, objects.end());
+	objectCount += records.size();
+
+	EmitObjects(firstRoot);
+}
+
+// the objects are only read once the material table is, so the streamed scene has reserved the material slots before any object arrives
+void SceneLoader::LoadObjectsFromArchive(TaskGraph& graph, DataArchiveFile& file, TaskGraph::TaskID materialRoot)
+{
+	graph.Add("read", [this, &graph, &file]()
+		{
+			std::shared_ptr<LoadedEntry> table = std::make_shared<LoadedEntry>();
+
+			std::expected<std::span<const char>, DataArchiveFile::Result> data = ReadEntry(file, SceneTable::ENTRY_NAME, table->storage);
+			if (!data.has_value()) // archives written before the scene table existed store every object and its children as separate entries
+			{
+				graph.Add("decode", [this, &file]() { LoadObjectsFromEntries(file); });
+				return;
+			}
+
+			table->data = *data;
+			graph.Add("decode", [this, &file, table]() { LoadObjectsFromTable(file, table->data); });
+		},
+		std::array{ materialRoot }
+	);
 }
 
-void SceneLoader::LoadObjectsFromArchive(DataArchiveFile& file)
+void SceneLoader::LoadObjectsFromEntries(DataArchiveFile& file)
 {
-	std::expected<std::vector<char>, DataArchiveFile::Result> root = file.ReadData("##object_root");
+	EntryStorage rootStorage;
+	std::expected<std::span<const char>, DataArchiveFile::Result> root = ReadEntry(file, "##object_root", rootStorage);
 	if (!root.has_value())
 	{
 		Console::WriteLine("no object root found for {}", Console::Severity::Warning, location); // scenes dont need to have objects, but itd be weird not to have any
@@ -106,89 +308,154 @@ void SceneLoader::LoadObjectsFromArchive(DataArchiveFile& file)
 	std::vector<std::string> childReferences = ReadNamedReferences(*root);
 	objects.reserve(childReferences.size());
 
+	EntryStorage objectStorage;
 	for (const std::string& child : childReferences)
 	{
-		std::expected<std::vector<char>, DataArchiveFile::Result> data = file.ReadData(child);
-		if (data.has_value())
-			ReadFullObject(file, *data, objects);
-		else
+		std::expected<std::span<const char>, DataArchiveFile::Result> data = ReadEntry(file, child, objectStorage);
+		if (!data.has_value())
+		{
 			Console::WriteLine("failed to read base object \"{}\"", Console::Severity::Error, child);
+			continue;
+		}
+
+		std::size_t first = objects.size();
+		ReadFullObject(file, *data, objects);
+		EmitObjects(first); // every base object is complete once it has been read, so it can already be streamed in
 	}
 }
 
-static ImageCreationData DeserializeImage(const BinarySpan& span)
-{
-	ImageCreationData ret{};
+// the texture entries of a material in the order they are referenced, the metallic texture is not used yet so it is not read either.
+// unlike the older archives, the roughness and ambient occlusion textures are read from their own entries
+static constexpr std::array<ImageCreationData MaterialCreationData::*, 5> MATERIAL_TEXTURES = { &MaterialCreationData::albedo, &MaterialCreationData::normal, nullptr, &MaterialCreationData::roughness, &MaterialCreationData::ambientOccl };
 
-	size_t size = 0;
-	span >> size;
+// newer archives store every texture as a separate entry, so that textures shared between materials are only stored once.
+// the textures of a material are read as one batch and every texture is put into the material as soon as it arrives, the material is complete once all of the returned tasks are done
+static std::vector<TaskGraph::TaskID> ReadMaterialFromReferences(TaskGraph& graph, const std::shared_ptr<DataArchiveFile>& file, const BinarySpan& data, MaterialCreationData& material)
+{
+	std::vector<TaskGraph::TaskID> ret;
 
-	if (size == 0)
+	std::vector<std::string> textures = ReadNamedReferences(data);
+	if (textures.size() != MATERIAL_TEXTURES.size())
+	{
+		Console::WriteLine("invalid amount of textures in material: {}", Console::Severity::Error, textures.size());
 		return ret;
+	}
 
-	ret.data.resize(size);
-	span.Read(ret.data.data(), size);
+	std::vector<ArchiveKey> keys;
+	std::vector<std::string> names;
+	std::vector<ImageCreationData MaterialCreationData::*> members;
 
-	return ret;
-}
+	for (std::size_t i = 0; i < textures.size(); i++)
+	{
+		if (MATERIAL_TEXTURES[i] == nullptr)
+			continue;
 
-static MaterialCreationData DeserializeMaterial(const BinarySpan& data)
-{
-	MaterialCreationData ret{};
-	ret.albedo = DeserializeImage(data);
-	ret.normal = DeserializeImage(data);
-	//ret.metallic = DeserializeImage(data);
-	ret.roughness = DeserializeImage(data);
-	ret.ambientOccl = DeserializeImage(data);
+		keys.push_back(textures[i]);
+		names.push_back(std::move(textures[i]));
+		members.push_back(MATERIAL_TEXTURES[i]);
+	}
+
+	// the texture is viewed straight in the mapping if it is stored as is, otherwise it stays in the buffer it is decompressed into
+	auto OnRead = [file, &material, names = std::move(names), members = std::move(members)](std::size_t index, std::expected<DataArchiveFile::EntryView, DataArchiveFile::Result>&& result)
+		{
+			if (!result.has_value())
+			{
+				Console::WriteLine("failed to read texture \"{}\"", Console::Severity::Error, names[index]);
+				return;
+			}
 
+			std::shared_ptr<SharedEntry> entry = std::make_shared<SharedEntry>(SharedEntry{ file, std::move(*result) });
+
+			ImageCreationData& image = material.*members[index]; // every texture writes to its own member, so no lock is needed
+			image.view = entry->entry.data;
+			image.viewOwner = std::move(entry);
+		};
+
+	file->ReadBatch(keys, std::move(OnRead), [&graph, &ret](DataArchiveFile::BatchRead read) { ret.push_back(graph.Add("read", std::move(read))); });
 	return ret;
 }
 
-void SceneLoader::LoadMaterialsFromArchive(DataArchiveFile& file)
+void SceneLoader::DecodeMaterial(TaskGraph& graph, const std::shared_ptr<DataArchiveFile>& file, const std::string& name, std::size_t index, DataArchiveFile::EntryView&& read)
 {
-	std::expected<std::vector<char>, DataArchiveFile::Result> root = file.ReadData("##material_root");
-	if (!root.has_value())
+	std::shared_ptr<DataArchiveFile::EntryView> entry = std::make_shared<DataArchiveFile::EntryView>(std::move(read));
+	MaterialCreationData& material = materials[index].emplace<MaterialCreationData>();
+
+	// archives written before the textures were stored separately have the textures inside of the material entry
+	if (file->HasEntry(ArchiveKey(name).Append("_albedo")))
 	{
-		Console::WriteLine("no material root found for {}", Console::Severity::Warning, location);
+		std::vector<TaskGraph::TaskID> textures = ReadMaterialFromReferences(graph, file, entry->data, material);
+		if (stream != nullptr)
+			graph.Add("decode", [this, index]() { EmitMaterial(index); }, textures);
+
 		return;
 	}
 
-	std::vector<std::string> references = ReadNamedReferences(*root);
-	materials.resize(references.size());
-
-	std::vector<int> indices(references.size());
-	for (int i = 0; i < indices.size(); i++)
-		indices[i] = i;
+	graph.Add("decode", [this, &material, name, index, entry]()
+		{
+			// the material is stored in the layout of the first version of the creation data. that layout is read exactly like before:
+			// the stored metallic and roughness textures end up as the roughness and ambient occlusion, so older scenes look the same as they did
+			if (!Reflection::Read(entry->data, material, 0))
+				Console::WriteLine("failed to deserialize material \"{}\"", Console::Severity::Error, name);
 
-	win32::CriticalSection critSection;
+			EmitMaterial(index);
+		}
+	);
+}
 
-	std::for_each(std::execution::par_unseq, indices.begin(), indices.end(),
-		[&](int i)
+// the material table is read first, after which the whole table is submitted to the archive as one batch. the archive starts the reads in file order
+// and every read is its own task, so the disk is kept busy with the next materials while the earlier ones are being decoded
+TaskGraph::TaskID SceneLoader::LoadMaterialsFromArchive(TaskGraph& graph, const std::shared_ptr<DataArchiveFile>& file)
+{
+	return graph.Add("read", [this, &graph, file]()
 		{
-			critSection.Lock();
-			std::expected<std::vector<char>, DataArchiveFile::Result> data = file.ReadData(references[i]);
-			critSection.Unlock();
-
-			materials[i] = DeserializeMaterial(*data);
+			EntryStorage rootStorage;
+			std::expected<std::span<const char>, DataArchiveFile::Result> root = ReadEntry(*file, "##material_root", rootStorage);
+			if (!root.has_value())
+			{
+				Console::WriteLine("no material root found for {}", Console::Severity::Warning, location);
+				return;
+			}
+
+			std::vector<std::string> references = ReadNamedReferences(*root);
+			materials.resize(references.size()); // the materials are only resized here, so the tasks below can safely refer to them
+			if (stream != nullptr)
+				stream->SetMaterialCount(references.size());
+
+			std::vector<ArchiveKey> keys(references.begin(), references.end());
+
+			auto OnRead = [this, &graph, file, names = std::move(references)](std::size_t index, std::expected<DataArchiveFile::EntryView, DataArchiveFile::Result>&& result)
+				{
+					if (!result.has_value())
+					{
+						Console::WriteLine("failed to read material \"{}\"", Console::Severity::Error, names[index]);
+						return;
+					}
+
+					DecodeMaterial(graph, file, names[index], index, std::move(*result));
+				};
+
+			file->ReadBatch(keys, std::move(OnRead), [&graph](DataArchiveFile::BatchRead read) { graph.Add("read", std::move(read)); });
 		}
 	);
-	/*materials.reserve(references.size());
-	for (const std::string& materialName : references)
-	{
-		std::expected<std::vector<char>, bool> data = file.ReadData(materialName);
-		if (data.has_value())
-			materials.push_back(DeserializeMaterial(*data));
-		else
-			Console::WriteLine("failed to read material {}", Console::Severity::Error, materialName);
-	}*/
 }
 
-void SceneLoader::LoadCustomFile()
+void SceneLoader::LoadCustomFile(TaskGraph& graph)
 {
-	DataArchiveFile file(location, DataArchiveFile::OpenMethod::Append);
+	// the textures of the materials can refer to the mapping of the archive, those keep the archive alive until the materials are created
+	std::shared_ptr<DataArchiveFile> file = std::make_shared<DataArchiveFile>(location, DataArchiveFile::OpenMethod::ReadOnly);
+	file->SetCache(cache);
+
+	for (const std::string& identifier : file->GetCollidingIdentifiers())
+		Console::WriteLine("the archive entry \"{}\" of {} has the same key as another entry and is ignored", Console::Severity::Warning, identifier, location);
+
+	// objects and materials dont share any data, after the material table the objects and materials are read at the same time
+	TaskGraph::TaskID materialRoot = LoadMaterialsFromArchive(graph, file);
+	LoadObjectsFromArchive(graph, *file, materialRoot);
+
+	graph.Wait(); // the object tasks refer to the file
 
-	LoadObjectsFromArchive(file);
-	LoadMaterialsFromArchive(file);
+	DataArchiveFile::ReadStatistics statistics = file->GetReadStatistics();
+	Console::WriteLine("read {:.1f} MB from {}: {} sequential reads, {} seeks", Console::Severity::Debug, statistics.bytesRead / (1024.0 * 1024.0), location, statistics.sequentialReads, statistics.randomReads);
 }
 
 static glm::vec3 ConvertAiVec3(const aiVector3D& vec)
@@ -196,31 +463,124 @@ static glm::vec3 ConvertAiVec3(const aiVector3D& vec)
 	return { vec.x, vec.y, vec.z };
 }
 
-static void RetrieveVertices(aiMesh* pMesh, std::vector<Vertex>& dst, glm::vec3& min, glm::vec3& max)
+constexpr std::size_t VERTEX_RANGE_SIZE = 64 * 1024; // the amount of vertices converted by one thread, smaller meshes are converted by the calling thread
+constexpr std::size_t VERTEX_BLOCK_SIZE = 1024;      // every attribute of a block is copied in its own loop, the block is small enough to stay in the cache between those loops
+constexpr std::size_t FACE_RANGE_SIZE = 128 * 1024;
+
+// calls the function with the index, start and end of every range of at most 'rangeSize' items. the ranges are spread over multiple threads if there is more than one
+template<typename Function>
+static void ForEachRange(std::size_t count, std::size_t rangeSize, const Function& function)
 {
-	dst.reserve(dst.size() + pMesh->mNumVertices);
-	for (unsigned int i = 0; i < pMesh->mNumVertices; i++)
+	std::size_t rangeCount = (count + rangeSize - 1) / rangeSize;
+	if (rangeCount <= 1)
+	{
+		if (count > 0)
+			function(0, 0, count);
+		return;
+	}
+
+	std::vector<std::size_t> ranges(rangeCount);
+	std::iota(ranges.begin(), ranges.end(), 0);
+
+	std::for_each(std::execution::par, ranges.begin(), ranges.end(),
+		[&](std::size_t range)
+		{
+			function(range, range * rangeSize, std::min((range + 1) * rangeSize, count));
+		});
+}
+
+static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "the bounds are calculated on the positions as packed floats");
+
+// the positions are packed as x, y, z, so four positions fill exactly three SSE registers. every lane always holds the same component,
+// which means the registers can be reduced on their own and only have to be folded into x, y and z at the end
+static void GetBounds(const aiVector3D* pPositions, std::size_t count, glm::vec3& min, glm::vec3& max)
+{
+	std::size_t i = 0;
+	if (count >= 4)
+	{
+		const float* pData = &pPositions->x;
+
+		__m128 min0 = _mm_loadu_ps(pData), min1 = _mm_loadu_ps(pData + 4), min2 = _mm_loadu_ps(pData + 8);
+		__m128 max0 = min0, max1 = min1, max2 = min2;
+
+		for (i = 4; i + 4 <= count; i += 4)
+		{
+			const float* pBlock = pData + i * 3;
+
+			__m128 block0 = _mm_loadu_ps(pBlock), block1 = _mm_loadu_ps(pBlock + 4), block2 = _mm_loadu_ps(pBlock + 8);
+
+			min0 = _mm_min_ps(min0, block0); max0 = _mm_max_ps(max0, block0);
+			min1 = _mm_min_ps(min1, block1); max1 = _mm_max_ps(max1, block1);
+			min2 = _mm_min_ps(min2, block2); max2 = _mm_max_ps(max2, block2);
+		}
+
+		std::array<float, 12> lowest{}, highest{};
+		_mm_storeu_ps(lowest.data(), min0); _mm_storeu_ps(lowest.data() + 4, min1); _mm_storeu_ps(lowest.data() + 8, min2);
+		_mm_storeu_ps(highest.data(), max0); _mm_storeu_ps(highest.data() + 4, max1); _mm_storeu_ps(highest.data() + 8, max2);
+
+		for (std::size_t lane = 0; lane < lowest.size(); lane++)
+		{
+			min[lane % 3] = std::min(min[lane % 3], lowest[lane]);
+			max[lane % 3] = std::max(max[lane % 3], highest[lane]);
+		}
+	}
+
+	for (; i < count; i++)
+	{
+		min = glm::min(ConvertAiVec3(pPositions[i]), min);
+		max = glm::max(ConvertAiVec3(pPositions[i]), max);
+	}
+}
+
+// the attributes are checked once per block instead of once per vertex, which leaves simple copy loops that the compiler can vectorize
+static void ConvertVertices(const aiMesh* pMesh, Vertex* pDst, std::size_t begin, std::size_t end)
+{
+	for (std::size_t block = begin; block < end; block += VERTEX_BLOCK_SIZE)
 	{
-		Vertex vertex{};
+		std::size_t blockEnd = std::min(block + VERTEX_BLOCK_SIZE, end);
 
-		vertex.position = ConvertAiVec3(pMesh->mVertices[i]);
+		for (std::size_t i = block; i < blockEnd; i++)
+			pDst[i].position = ConvertAiVec3(pMesh->mVertices[i]);
 
 		if (pMesh->HasNormals())
-			vertex.normal = ConvertAiVec3(pMesh->mNormals[i]);
+			for (std::size_t i = block; i < blockEnd; i++)
+				pDst[i].normal = ConvertAiVec3(pMesh->mNormals[i]);
 
 		if (pMesh->mTextureCoords[0])
-			vertex.textureCoordinates = ConvertAiVec3(pMesh->mTextureCoords[0][i]);
+			for (std::size_t i = block; i < blockEnd; i++)
+				pDst[i].textureCoordinates = ConvertAiVec3(pMesh->mTextureCoords[0][i]);
 
 		if (pMesh->HasTangentsAndBitangents())
 		{
-			vertex.tangent = ConvertAiVec3(pMesh->mTangents[i]);
-			vertex.biTangent = ConvertAiVec3(pMesh->mBitangents[i]);
+			for (std::size_t i = block; i < blockEnd; i++)
+				pDst[i].tangent = ConvertAiVec3(pMesh->mTangents[i]);
+
+			for (std::size_t i = block; i < blockEnd; i++)
+				pDst[i].biTangent = ConvertAiVec3(pMesh->mBitangents[i]);
 		}
+	}
+}
 
-		min = glm::min(vertex.position, min);
-		max = glm::max(vertex.position, max);
-		
-		dst.push_back(vertex);
+// large meshes are split into ranges that are converted on separate threads, every range has its own bounds which are merged afterwards
+static void RetrieveVertices(aiMesh* pMesh, std::vector<Vertex>& dst, glm::vec3& min, glm::vec3& max)
+{
+	std::size_t offset = dst.size();
+	dst.resize(offset + pMesh->mNumVertices);
+
+	Vertex* pVertices = dst.data() + offset;
+
+	std::vector<std::pair<glm::vec3, glm::vec3>> bounds((pMesh->mNumVertices + VERTEX_RANGE_SIZE - 1) / VERTEX_RANGE_SIZE, { min, max });
+
+	ForEachRange(pMesh->mNumVertices, VERTEX_RANGE_SIZE, [&](std::size_t range, std::size_t begin, std::size_t end)
+		{
+			ConvertVertices(pMesh, pVertices, begin, end);
+			GetBounds(pMesh->mVertices + begin, end - begin, bounds[range].first, bounds[range].second);
+		});
+
+	for (const std::pair<glm::vec3, glm::vec3>& range : bounds)
+	{
+		min = glm::min(range.first, min);
+		max = glm::max(range.second, max);
 	}
 }
 
@@ -235,6 +595,26 @@ static std::vector<Vertex> RetrieveVertices(aiMesh* pMesh, glm::vec3& min, glm::
 
 static void RetrieveIndices(aiMesh* pMesh, std::vector<uint32_t>& dst, uint32_t offset)
 {
+	if (pMesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE) // every face has three indices, so the position of every face is known up front and the faces can be copied in parallel
+	{
+		std::size_t first = dst.size();
+		dst.resize(first + static_cast<std::size_t>(pMesh->mNumFaces) * 3);
+
+		std::uint32_t* pIndices = dst.data() + first;
+
+		ForEachRange(pMesh->mNumFaces, FACE_RANGE_SIZE, [&](std::size_t, std::size_t begin, std::size_t end)
+			{
+				for (std::size_t i = begin; i < end; i++)
+				{
+					const aiFace& face = pMesh->mFaces[i];
+					pIndices[i * 3 + 0] = offset + face.mIndices[0];
+					pIndices[i * 3 + 1] = offset + face.mIndices[1];
+					pIndices[i * 3 + 2] = offset + face.mIndices[2];
+				}
+			});
+		return;
+	}
+
 	dst.reserve(dst.size() + pMesh->mNumFaces * 3);
 	for (unsigned int i = 0; i < pMesh->mNumFaces; i++)
 	{
@@ -366,45 +746,194 @@ static std::string GetTextureFile(const aiScene* scene, aiTextureType type, int
 	return res == aiReturn_SUCCESS ? (base / str.C_Str()).string() : "";
 }
 
-void SceneLoader::LoadAssimpFile()
+// the state shared by the tasks that convert an imported scene, the scene is released once every task is done with it
+struct SceneLoader::ImportedScene
 {
-	const aiScene* scene = aiImportFile(location.c_str(), aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_OptimizeGraph | aiProcess_OptimizeMeshes);
-	
-	if (scene == nullptr) // check if the file could be read
-		throw std::runtime_error("Failed to find or read file at " + location);
+	const aiScene* scene = nullptr;
+	std::optional<ImportCache::Key> cacheKey; // only set if the converted scene should be stored in the import cache
 
-	const char* err = aiGetErrorString();
-	if (err != nullptr && err[0] != '\0')
-		Console::WriteLine(err, Console::Severity::Error);
+	std::vector<MeshCreationData> meshes;
+	std::vector<MeshOptimizer::Report> optimizations; // the statistics of every mesh before and after it was optimized
+	std::vector<std::uint32_t> remainingUses; // the amount of nodes that still need the mesh, the last one takes it instead of copying it
 
-	objectCount = 1;
-	ObjectCreationData root = RetrieveObject(scene, scene->mRootNode, glm::mat4(1)); // for now we ignore the root node
-	objects.push_back(root);
+	void CountMeshUses(const aiNode* node)
+	{
+		for (unsigned int i = 0; i < node->mNumMeshes; i++)
+			remainingUses[node->mMeshes[i]]++;
 
-	if (scene->HasAnimations())
-		animations.reserve(scene->mNumAnimations);
+		for (unsigned int i = 0; i < node->mNumChildren; i++)
+			CountMeshUses(node->mChildren[i]);
+	}
 
-	for (unsigned int i = 0; i < scene->mNumAnimations; i++)
+	MeshCreationData TakeMesh(unsigned int index)
 	{
-		animations.emplace_back(scene->mAnimations[i], scene->mRootNode);
+		return --remainingUses[index] == 0 ? std::move(meshes[index]) : meshes[index];
 	}
+};
 
-	fs::path baseDir = fs::path(location).parent_path();
+// the file is hashed first, if the import cache has an entry for it then assimp is skipped entirely
+void SceneLoader::LoadAssimpFile(TaskGraph& graph)
+{
+	std::shared_ptr<ImportedScene> imported = std::make_shared<ImportedScene>();
 
-	for (unsigned int i = 0; i < scene->mNumMaterials; i++)
-	{
-		MaterialCreateInfo data{};
+	graph.Add("read", [this, &graph, imported]()
+		{
+			if (importCache != nullptr)
+			{
+				imported->cacheKey = ImportCache::CreateKey(location, ASSIMP_IMPORT_FLAGS);
+				if (imported->cacheKey.has_value() && LoadFromImportCache(*imported->cacheKey))
+					return;
+			}
+			ImportWithAssimp(graph, imported);
+		}
+	);
+
+	graph.Wait();
+}
+
+bool SceneLoader::LoadFromImportCache(const ImportCache::Key& key)
+{
+	std::optional<ImportCache::Contents> contents = importCache->Find(key, fs::path(location).parent_path());
+	if (!contents.has_value())
+		return false;
+
+	objectCount = contents->objectCount;
+	objects = std::move(contents->objects);
+	materials.assign(contents->materials.begin(), contents->materials.end());
+
+	if (stream != nullptr)
+		stream->SetMaterialCount(materials.size());
 
-		data.albedo = GetTextureFile(scene, aiTextureType_DIFFUSE, i, 0, baseDir);
-		data.normal = GetTextureFile(scene, aiTextureType_NORMALS, i, 0, baseDir);
-		data.roughness = GetTextureFile(scene, aiTextureType_DIFFUSE_ROUGHNESS, i, 0, baseDir);
-		data.metallic = GetTextureFile(scene, aiTextureType_METALNESS, i, 0, baseDir);
-		data.ambientOcclusion = GetTextureFile(scene, aiTextureType_AMBIENT_OCCLUSION, i, 0, baseDir);
+	for (std::size_t i = 0; i < materials.size(); i++)
+		EmitMaterial(i);
+	EmitObjects(0);
 
-		materials.push_back(data);
+	Console::WriteLine("loaded {} from the import cache ({})", Console::Severity::Debug, location, key.ToFileName());
+	return true;
+}
+
+void SceneLoader::StoreInImportCache(const ImportCache::Key& key)
+{
+	if (!animations.empty()) // the animations are built from the assimp scene itself, they cannot be stored yet
+	{
+		Console::WriteLine("{} has animations, so it is not stored in the import cache", Console::Severity::Debug, location);
+		return;
 	}
 
-	aiReleaseImport(scene);
+	std::vector<MaterialCreateInfo> createInfos;
+	createInfos.reserve(materials.size());
+
+	for (const std::variant<MaterialCreationData, MaterialCreateInfo>& material : materials)
+		createInfos.push_back(std::get<MaterialCreateInfo>(material)); // imported materials always refer to their textures by path
+
+	if (importCache->Store(key, objects, createInfos, objectCount, fs::path(location).parent_path()))
+		Console::WriteLine("stored {} in the import cache ({})", Console::Severity::Debug, location, key.ToFileName());
+}
+
+// every mesh is converted by its own task, the hierarchy is built once all meshes are converted.
+// if the scene is going to be cached, it is only streamed once it has been stored, because streaming moves the objects out of the loader
+void SceneLoader::ImportWithAssimp(TaskGraph& graph, std::shared_ptr<ImportedScene> imported)
+{
+	graph.Add("import", [this, &graph, imported]()
+		{
+			const aiScene* scene = aiImportFile(location.c_str(), ASSIMP_IMPORT_FLAGS);
+
+			if (scene == nullptr) // check if the file could be read
+				throw std::runtime_error("Failed to find or read file at " + location);
+
+			const char* err = aiGetErrorString();
+			if (err != nullptr && err[0] != '\0')
+				Console::WriteLine(err, Console::Severity::Error);
+
+			imported->scene = scene;
+			imported->meshes.resize(scene->mNumMeshes);
+			imported->optimizations.resize(scene->mNumMeshes);
+			imported->remainingUses.resize(scene->mNumMeshes);
+
+			std::vector<TaskGraph::TaskID> meshTasks(scene->mNumMeshes);
+			for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+				meshTasks[i] = graph.Add("build mesh", [this, imported, i]()
+					{
+						imported->meshes[i] = RetrieveMeshData(imported->scene->mMeshes[i]);
+						imported->optimizations[i] = MeshOptimizer::Optimize(imported->meshes[i]);
+					}
+				);
+
+			std::array<TaskGraph::TaskID, 3> conversions{};
+
+			conversions[0] = graph.Add("decode", [this, imported]()
+				{
+					MeshOptimizer::Report total{};
+					for (const MeshOptimizer::Report& report : imported->optimizations)
+					{
+						total.before += report.before;
+						total.after += report.after;
+					}
+					Console::WriteLine("optimized the meshes of {}: {} -> {} vertices, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", Console::Severity::Debug, location, total.before.vertexCount, total.after.vertexCount, total.before.GetACMR(), total.after.GetACMR(), total.before.GetATVR(), total.after.GetATVR());
+
+					imported->CountMeshUses(imported->scene->mRootNode);
+
+					objectCount = 1;
+					objects.push_back(RetrieveObject(*imported, imported->scene->mRootNode, glm::mat4(1))); // for now we ignore the root node
+
+					if (!imported->cacheKey.has_value())
+						EmitObjects(0);
+				},
+				meshTasks
+			);
+
+			conversions[1] = graph.Add("decode", [this, imported]()
+				{
+					const aiScene* scene = imported->scene;
+
+					animations.reserve(scene->mNumAnimations);
+					for (unsigned int i = 0; i < scene->mNumAnimations; i++)
+						animations.emplace_back(scene->mAnimations[i], scene->mRootNode);
+				}
+			);
+
+			conversions[2] = graph.Add("decode", [this, imported]()
+				{
+					const aiScene* scene = imported->scene;
+					fs::path baseDir = fs::path(location).parent_path();
+
+					if (stream != nullptr)
+						stream->SetMaterialCount(scene->mNumMaterials);
+
+					for (unsigned int i = 0; i < scene->mNumMaterials; i++)
+					{
+						MaterialCreateInfo data{};
+
+						data.albedo = GetTextureFile(scene, aiTextureType_DIFFUSE, i, 0, baseDir);
+						data.normal = GetTextureFile(scene, aiTextureType_NORMALS, i, 0, baseDir);
+						data.roughness = GetTextureFile(scene, aiTextureType_DIFFUSE_ROUGHNESS, i, 0, baseDir);
+						data.metallic = GetTextureFile(scene, aiTextureType_METALNESS, i, 0, baseDir);
+						data.ambientOcclusion = GetTextureFile(scene, aiTextureType_AMBIENT_OCCLUSION, i, 0, baseDir);
+
+						materials.push_back(data);
+						if (!imported->cacheKey.has_value())
+							EmitMaterial(materials.size() - 1);
+					}
+				}
+			);
+
+			graph.Add("import", [imported]() { aiReleaseImport(imported->scene); }, conversions);
+
+			if (!imported->cacheKey.has_value())
+				return;
+
+			graph.Add("write cache", [this, imported]()
+				{
+					StoreInImportCache(*imported->cacheKey);
+
+					for (std::size_t i = 0; i < materials.size(); i++)
+						EmitMaterial(i);
+					EmitObjects(0);
+				},
+				conversions
+			);
+		}
+	);
 }
 
 static aiLight* NodeAsLight(const aiScene* scene, const aiNode* node)
@@ -436,8 +965,10 @@ static Light::Type AiTypeToInternalType(aiLightSourceType type)
 	return Light::Type::Point;
 }
 
-ObjectCreationData SceneLoader::RetrieveObject(const aiScene* scene, const aiNode* node, glm::mat4 parentTrans)
+ObjectCreationData SceneLoader::RetrieveObject(ImportedScene& imported, const aiNode* node, glm::mat4 parentTrans)
 {
+	const aiScene* scene = imported.scene;
+
 	ObjectCreationData creationData;
 	creationData.name = node->mName.length == 0 ? "NO_NAME" + std::to_string(unnamedObjectCount) : node->mName.C_Str();
 
@@ -458,7 +989,7 @@ ObjectCreationData SceneLoader::RetrieveObject(const aiScene* scene, const aiNod
 
 		if (creationData.hasMesh)
 		{
-			creationData.mesh = RetrieveMeshData(scene->mMeshes[node->mMeshes[0]]);
+			creationData.mesh = imported.TakeMesh(node->mMeshes[0]);
 			creationData.type = ObjectCreationData::Type::Mesh;
 		}
 
@@ -466,11 +997,11 @@ ObjectCreationData SceneLoader::RetrieveObject(const aiScene* scene, const aiNod
 		{
 			ObjectCreationData child{};
 			child.name = creationData.name + std::to_string(i);
-			child.mesh = RetrieveMeshData(scene->mMeshes[node->mMeshes[i]]);
+			child.mesh = imported.TakeMesh(node->mMeshes[i]);
 			child.type = ObjectCreationData::Type::Mesh;
 			child.hasMesh = true;
 
-			creationData.children.push_back(child);
+			creationData.children.push_back(std::move(child));
 		}
 	}
 	objectCount++;
@@ -479,7 +1010,7 @@ ObjectCreationData SceneLoader::RetrieveObject(const aiScene* scene, const aiNod
 		creationData.children.reserve(creationData.children.size() + node->mNumChildren);
 
 	for (unsigned int i = 0; i < node->mNumChildren; i++)
-		creationData.children.push_back(RetrieveObject(scene, node->mChildren[i], GetMat4(node->mTransformation)));
+		creationData.children.push_back(RetrieveObject(imported, node->mChildren[i], GetMat4(node->mTransformation)));
 	
 	return creationData;
 }
@@ -0,0 +1,123 @@
+module IO.SceneStream;
+
+import std;
+
+import IO.CreationData;
+
+import Renderer.Material;
+
+static double GetMilliseconds(SceneStream::Clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+SceneStream::SceneStream() : start(Clock::now()) {}
+
+void SceneStream::SetMaterialCount(std::size_t count)
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+	materialCount = count;
+}
+
+void SceneStream::PushMaterial(std::size_t index, MaterialData&& data)
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+	materials.emplace_back(index, std::move(data));
+}
+
+void SceneStream::PushObject(ObjectCreationData&& data)
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+	objects.push_back(std::move(data));
+}
+
+void SceneStream::Finish()
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+	isFinished = true;
+}
+
+bool SceneStream::Pop(std::optional<std::size_t>& outMaterialCount, std::optional<PendingMaterial>& outMaterial, std::optional<ObjectCreationData>& outObject)
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+
+	if (materialCount.has_value())
+	{
+		outMaterialCount = std::exchange(materialCount, std::nullopt);
+		return true;
+	}
+
+	if (!materials.empty())
+	{
+		outMaterial = std::move(materials.front());
+		materials.pop_front();
+		return true;
+	}
+
+	if (!objects.empty())
+	{
+		outObject = std::move(objects.front());
+		objects.pop_front();
+		return true;
+	}
+
+	if (isFinished && !isComplete)
+	{
+		isComplete = true;
+		statistics.timeToComplete = GetMilliseconds(Clock::now() - start);
+	}
+	return false;
+}
+
+bool SceneStream::Integrate(Clock::duration budget, const Integrator& integrator)
+{
+	Clock::time_point end = Clock::now() + budget;
+	bool hasAdded = false;
+
+	do
+	{
+		std::optional<std::size_t> count;
+		std::optional<PendingMaterial> material;
+		std::optional<ObjectCreationData> object;
+
+		if (!Pop(count, material, object))
+			break;
+
+		// the scene is changed without holding the lock, so the loader can keep pushing while an object is being created
+		if (count.has_value())
+			integrator.reserveMaterials(*count);
+
+		if (material.has_value())
+			integrator.addMaterial(material->index, material->data);
+
+		if (object.has_value())
+			integrator.addObject(*object);
+
+		std::lock_guard<std::mutex> lockGuard(mutex);
+
+		hasAdded = true;
+		statistics.materialCount += material.has_value() ? 1 : 0;
+		statistics.objectCount += object.has_value() ? 1 : 0;
+
+		if (object.has_value() && statistics.timeToFirstObject < 0.0)
+			statistics.timeToFirstObject = GetMilliseconds(Clock::now() - start);
+	}
+	while (Clock::now() < end);
+
+	std::lock_guard<std::mutex> lockGuard(mutex);
+	statistics.frameCount += hasAdded ? 1 : 0;
+
+	return isComplete;
+}
+
+bool SceneStream::IsComplete() const
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+	return isComplete;
+}
+
+SceneStream::Statistics SceneStream::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+	return statistics;
+}
\ No newline at end of file
@@ -1,3 +1,7 @@
+module;
+
+#include "core/Console.h"
+
 module IO.SceneWriter;
 
 import std;
@@ -11,104 +15,276 @@ import Renderer.Texture;
 
 import IO.DataArchiveFile;
 import IO.BinaryStream;
+import IO.Compression;
+import IO.SceneTable;
 
-import System.CriticalSection;
-
-static void WriteNamedReferencesToStream(BinaryStream& stream, const std::vector<Object*>& objects)
+struct ArchiveEntry
 {
-	std::uint32_t referenceCount = static_cast<uint32_t>(objects.size());
-	stream << referenceCount;
+	std::string identifier;
+	std::vector<char> data;
+};
 
+static std::size_t CountObjects(const std::vector<Object*>& objects)
+{
+	std::size_t ret = objects.size();
 	for (const Object* pObject : objects)
+		ret += CountObjects(pObject->GetChildren());
+
+	return ret;
+}
+
+static std::string GetPayloadName(std::uint32_t recordIndex)
+{
+	return "##object" + std::to_string(recordIndex) + "_payload";
+}
+
+// the hierarchy is walked with a stack instead of recursion, the records end up in depth first order with every parent before its children.
+// the amount of records is known up front, so the blob is written straight after the space for the records instead of being copied there afterwards.
+// the data of meshes is not written to the blob, those objects are added to outExternal with the index of their record
+static std::vector<char> SerializeSceneTable(const std::vector<Object*>& objects, std::vector<std::pair<std::uint32_t, const Object*>>& outExternal)
+{
+	const std::size_t objectCount = CountObjects(objects);
+	const std::size_t blobOffset = sizeof(SceneTable::Header) + objectCount * sizeof(SceneTable::Record);
+
+	std::vector<SceneTable::Record> records;
+	records.reserve(objectCount);
+
+	BinaryStream stream;
+	stream.data.resize(blobOffset);
+
+	std::vector<std::pair<const Object*, std::uint32_t>> stack; // the objects left to write and the index of the record of their parent
+	for (auto it = objects.rbegin(); it != objects.rend(); it++) // pushed in reverse, so that the objects are popped in their original order
+		stack.emplace_back(*it, SceneTable::NO_PARENT);
+
+	while (!stack.empty())
 	{
-		std::uint32_t strLen = static_cast<std::uint32_t>(pObject->name.size());
+		auto [pObject, parent] = stack.back();
+		stack.pop_back();
 
-		stream << strLen;
-		stream.Write(pObject->name.data(), strLen);
+		std::uint32_t index = static_cast<std::uint32_t>(records.size());
+		SceneTable::Record& record = records.emplace_back();
+
+		const Transform& transform = pObject->transform;
+
+		record.parent = parent;
+		record.type = static_cast<std::int32_t>(pObject->GetType());
+		record.position = { transform.position.x, transform.position.y, transform.position.z };
+		record.scale = { transform.scale.x, transform.scale.y, transform.scale.z };
+		record.rotation = { transform.rotation.w, transform.rotation.x, transform.rotation.y, transform.rotation.z };
+
+		record.nameOffset = stream.data.size() - blobOffset;
+		record.nameLength = static_cast<std::uint32_t>(pObject->name.size());
+		stream.WriteRange(pObject->name);
+
+		if (pObject->IsType(Object::InheritType::Mesh)) // meshes are large and rarely change, so they are kept out of the table
+		{
+			record.flags = SceneTable::RecordFlagExternalPayload;
+			record.payload = ArchiveKey(GetPayloadName(index)).hash;
+			outExternal.emplace_back(index, pObject);
+		}
+		else
+		{
+			record.payload = stream.data.size() - blobOffset;
+			pObject->SerializeDataIntoStream(stream);
+			record.payloadSize = stream.data.size() - blobOffset - record.payload;
+		}
+
+		const std::vector<Object*>& children = pObject->GetChildren();
+		for (auto it = children.rbegin(); it != children.rend(); it++)
+			stack.emplace_back(*it, index);
 	}
+
+	SceneTable::Header header{};
+	header.recordCount = static_cast<std::uint32_t>(records.size());
+	header.blobSize = stream.data.size() - blobOffset;
+
+	std::memcpy(stream.data.data(), &header, sizeof(header));
+	std::memcpy(stream.data.data() + sizeof(header), records.data(), records.size() * sizeof(SceneTable::Record));
+
+	return std::move(stream.data);
 }
 
-static void WriteFullObjectToArchive(DataArchiveFile& archive, const Object* pObject)
+static void AddToArchive(DataArchiveFile& archive, std::string_view identifier, const std::span<const char>& data, CompressionCodec codec = CompressionCodec::LZ4)
 {
-	archive.AddData(pObject->name, pObject->Serialize());
+	if (archive.AddData(identifier, data, codec) == DataArchiveFile::Result::KeyCollision)
+		Console::WriteLine("failed to save \"{}\", its key collides with another entry", Console::Severity::Error, identifier);
+}
 
-	if (!pObject->HasChildren())
-		return;
+static constexpr std::size_t MIN_DICTIONARY_SAMPLES = 64; // training mostly fails with fewer samples, and a dictionary trained on so few would barely help
+static constexpr std::uint64_t DICTIONARY_DEGRADATION = 5; // the old dictionary is replaced if it compresses the samples 1 / DICTIONARY_DEGRADATION worse than a new one
+
+static std::uint64_t GetCompressedSize(const std::vector<std::span<const char>>& samples, const CompressionDictionary* pDictionary)
+{
+	std::uint64_t ret = 0;
+	for (const std::span<const char>& sample : samples)
+	{
+		std::vector<char> compressed = Compression::Compress(sample, CompressionCodec::LZ4, 0, pDictionary);
+		ret += compressed.empty() ? sample.size() : compressed.size(); // data that cannot be compressed is stored as is
+	}
+	return ret;
+}
+
+// the entries are tiny and very similar to each other, so they compress a lot better with a dictionary trained on all of them.
+// replacing the dictionary invalidates every entry compressed with it, so the dictionary of the archive is kept unless it has become a lot worse than a new one.
+// when the archive is compacted everything is rewritten anyway, so then any improvement is worth it. returns true if the dictionary has been replaced
+static bool UpdateCompressionDictionary(DataArchiveFile& archive, const std::vector<ArchiveEntry>& entries, bool isCompacting)
+{
+	if (entries.size() < MIN_DICTIONARY_SAMPLES)
+		return false;
+
+	std::vector<std::span<const char>> samples;
+	samples.reserve(entries.size());
 
-	BinaryStream childReferences;
-	WriteNamedReferencesToStream(childReferences, pObject->GetChildren());
+	for (const ArchiveEntry& entry : entries)
+		samples.push_back(entry.data);
 
-	archive.AddData(pObject->name + "_ref_children", childReferences.data);
+	std::vector<char> data = Compression::TrainDictionary(samples);
+	if (data.empty())
+		return false;
 
-	for (Object* pObject : pObject->GetChildren())
-		WriteFullObjectToArchive(archive, pObject);
+	const CompressionDictionary* pCurrent = archive.GetCompressionDictionary();
+	if (pCurrent != nullptr)
+	{
+		CompressionDictionary trained(data);
+
+		std::uint64_t currentSize = GetCompressedSize(samples, pCurrent);
+		std::uint64_t trainedSize = GetCompressedSize(samples, &trained);
+
+		bool isWorthReplacing = isCompacting ? trainedSize < currentSize : trainedSize + trainedSize / DICTIONARY_DEGRADATION < currentSize;
+		if (!isWorthReplacing)
+			return false;
+	}
+
+	archive.SetCompressionDictionary(std::move(data));
+	return true;
 }
 
-static void WriteTextureToStream(BinaryStream& stream, const Texture* pTexture)
-{
-	std::vector<char> data = pTexture->GetAsInternalFormat();
-	stream << data.size();
+static constexpr std::array<std::string_view, 5> TEXTURE_SUFFIXES = { "_albedo", "_normal", "_metallic", "_roughness", "_ambient_occlusion" };
 
-	stream.Write(data.data(), data.size() * sizeof(char));
+static std::string GetMaterialName(std::uint32_t index)
+{
+	return "##material" + std::to_string(index);
 }
 
-static void WriteMaterialsToArchive(DataArchiveFile& file)
+// the loader reads the material table first and then the textures of every material, so the material entries are added before the textures
+static std::vector<ArchiveEntry> SerializeMaterials()
 {
+	std::vector<ArchiveEntry> entries;
+
 	BinaryStream stream;
 	std::uint32_t matCount = static_cast<std::uint32_t>(Mesh::materials.size() - 1);
 	stream << matCount;
 
 	for (std::uint32_t i = 1; i < matCount + 1; i++)
 	{
-		std::string name = "##material" + std::to_string(i);
+		std::string name = GetMaterialName(i);
 		std::uint32_t strLen = static_cast<std::uint32_t>(name.size());
 		stream << strLen;
 
 		stream.Write(name.data(), strLen);
 	}
 
-	file.AddData("##material_root", stream.data);	
+	entries.emplace_back("##material_root", std::move(stream.data));
 
-	std::vector<int> indices(matCount);
-	for (int i = 0; i < indices.size(); i++)
-		indices[i] = i + 1;
+	for (std::uint32_t i = 1; i < matCount + 1; i++)
+	{
+		std::string name = GetMaterialName(i);
 
-	win32::CriticalSection critSection;
+		BinaryStream matStream; // the material only references its textures, which are stored as separate entries
+		std::uint32_t textureCount = static_cast<std::uint32_t>(TEXTURE_SUFFIXES.size());
+		matStream << textureCount;
 
-	std::for_each(std::execution::par_unseq, indices.begin(), indices.end(),
-		[&](int i)
+		for (std::string_view suffix : TEXTURE_SUFFIXES)
 		{
-			BinaryStream matStream;
+			std::string textureName = name + std::string(suffix);
+			std::uint32_t strLen = static_cast<std::uint32_t>(textureName.size());
 
-			std::string name = "##material" + std::to_string(i);
-			const Material& mat = Mesh::materials[i];
+			matStream << strLen;
+			matStream.Write(textureName.data(), strLen);
+		}
 
-			WriteTextureToStream(matStream, mat.albedo);
-			WriteTextureToStream(matStream, mat.normal);
-			WriteTextureToStream(matStream, mat.metallic);
-			WriteTextureToStream(matStream, mat.roughness);
-			WriteTextureToStream(matStream, mat.ambientOcclusion);
+		entries.emplace_back(std::move(name), std::move(matStream.data));
+	}
 
-			win32::CriticalLockGuard lockGuard(critSection);
-			file.AddData(name, matStream.data);
-		}
-	);
+	return entries;
+}
+
+// every payload is its own entry, so the archive only appends the payloads that changed and stores identical payloads once
+static void WritePayloadsToArchive(DataArchiveFile& file, const std::vector<std::pair<std::uint32_t, const Object*>>& external)
+{
+	BinaryStream stream;
+	for (const auto& [index, pObject] : external)
+	{
+		stream.Clear();
+		pObject->SerializeDataIntoStream(stream);
+
+		AddToArchive(file, GetPayloadName(index), stream.data);
+	}
+}
+
+static void WriteTexturesToArchive(DataArchiveFile& file)
+{
+	std::uint32_t matCount = static_cast<std::uint32_t>(Mesh::materials.size() - 1);
+
+	// the textures are read back in parallel, but are added in order. the batches keep the amount of textures in RAM bounded
+	const std::uint32_t batchSize = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (std::uint32_t batchStart = 1; batchStart < matCount + 1; batchStart += batchSize)
+	{
+		std::uint32_t batchEnd = std::min(batchStart + batchSize, matCount + 1);
+
+		std::vector<std::array<std::vector<char>, TEXTURE_SUFFIXES.size()>> textureData(batchEnd - batchStart);
+		std::vector<std::uint32_t> indices(batchEnd - batchStart);
+		std::iota(indices.begin(), indices.end(), batchStart);
+
+		std::for_each(std::execution::par_unseq, indices.begin(), indices.end(),
+			[&](std::uint32_t i)
+			{
+				const Material& mat = Mesh::materials[i];
+				const std::array<const Texture*, TEXTURE_SUFFIXES.size()> textures = { mat.albedo, mat.normal, mat.metallic, mat.roughness, mat.ambientOcclusion };
+
+				for (std::size_t j = 0; j < textures.size(); j++)
+					textureData[i - batchStart][j] = textures[j]->GetAsInternalFormat();
+			}
+		);
+
+		// textures are large and only read once per load, so the better ratio is worth the slower decompression.
+		// textures that are shared by multiple materials (like the default textures) are only stored once by the archive
+		for (std::uint32_t i = batchStart; i < batchEnd; i++)
+			for (std::size_t j = 0; j < TEXTURE_SUFFIXES.size(); j++)
+				AddToArchive(file, GetMaterialName(i) + std::string(TEXTURE_SUFFIXES[j]), textureData[i - batchStart][j], CompressionCodec::Zstd);
+	}
 }
 
 void SceneWriter::WriteSceneToArchive(const std::string& file, const Scene* scene)
 {
-	DataArchiveFile archive(file, DataArchiveFile::OpenMethod::Clear);
+	DataArchiveFile archive(file, DataArchiveFile::OpenMethod::Append);
 	if (!archive.IsValid())
 		return;
 
-	BinaryStream rootReferences;
-	WriteNamedReferencesToStream(rootReferences, scene->objects);
-	archive.AddData("##object_root", rootReferences.data);
+	archive.ClearDictionary(); // everything is added again, but only data that has changed since the last write will actually be appended
+	archive.StartStreaming();  // every entry is written as soon as it is added, so the compressed scene never has to be in RAM all at once
+
+	std::vector<ArchiveEntry> materialEntries = SerializeMaterials();
+	UpdateCompressionDictionary(archive, materialEntries, false); // this has to happen before anything is added, otherwise the entries added before would be recompressed and appended again
+
+	// the entries are added in the order the loader reads them, so that loading from a cold disk is mostly sequential
+	for (const ArchiveEntry& entry : materialEntries)
+		AddToArchive(archive, entry.identifier, entry.data);
 
-	for (Object* pObject : scene->objects)
-		WriteFullObjectToArchive(archive, pObject);
+	WriteTexturesToArchive(archive);
 
-	WriteMaterialsToArchive(archive);
+	std::vector<std::pair<std::uint32_t, const Object*>> external;
+	AddToArchive(archive, SceneTable::ENTRY_NAME, SerializeSceneTable(scene->objects, external)); // the entire hierarchy is a single entry, so loading it takes one read
+	WritePayloadsToArchive(archive, external);
 
 	archive.WriteToFile();
+
+	if (archive.GetUnusedSize() > archive.GetFileSize() / 2) // only compact when most of the file is unreachable, since compacting rewrites the entire file
+	{
+		if (UpdateCompressionDictionary(archive, materialEntries, true)) // the recompressed entries are appended, the compaction removes the old ones
+			archive.WriteToFile();
+
+		archive.Compact();
+	}
 }
\ No newline at end of file
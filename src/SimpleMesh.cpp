@@ -13,7 +13,6 @@ SimpleMesh SimpleMesh::Create(const std::span<const Vertex>& vertices)
 
 SimpleMesh& SimpleMesh::operator=(SimpleMesh&& rhs) noexcept
 {
-	std::swap(defVertexMemory, rhs.defVertexMemory);
 	std::swap(vertexMemory, rhs.vertexMemory);
 
 	rhs.Destroy(); // this call should not really be necessary, but just in case
@@ -23,14 +22,14 @@ SimpleMesh& SimpleMesh::operator=(SimpleMesh&& rhs) noexcept
 
 SimpleMesh::SimpleMesh(const std::span<const Vertex>& vertices)
 {
-	defVertexMemory = Renderer::g_defaultVertexBuffer.SubmitNewData(vertices);
-	vertexMemory    = Renderer::g_vertexBuffer.SubmitNewData(vertices);
+	std::vector<PackedVertex> packed(vertices.size());
+	std::transform(vertices.begin(), vertices.end(), packed.begin(), PackedVertex::Pack);
+
+	vertexMemory = Renderer::g_vertexBuffer.SubmitNewData(packed); // a simple mesh is never animated, so it has no unanimated copy
 }
 
 void SimpleMesh::Destroy()
 {
-	if (defVertexMemory != 0)
-		Renderer::g_defaultVertexBuffer.DestroyData(defVertexMemory);
 	if (vertexMemory != 0)
 		Renderer::g_vertexBuffer.DestroyData(vertexMemory);
 }
\ No newline at end of file
@@ -0,0 +1,180 @@
+module System.TaskGraph;
+
+import std;
+
+TaskGraph::TaskGraph(std::uint32_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	threads.reserve(threadCount);
+	for (std::uint32_t i = 0; i < threadCount; i++)
+		threads.emplace_back(&TaskGraph::Work, this);
+}
+
+TaskGraph::~TaskGraph()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		tasksCompleted.wait(lock, [&]() { return pendingCount == 0; }); // a task that is still waiting on a dependency is not in the ready queue yet, so the threads cannot just drain that
+
+		isStopping = true;
+	}
+	taskAvailable.notify_all();
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+std::uint32_t TaskGraph::GetStageIndex(std::string_view name)
+{
+	auto it = std::find_if(stages.begin(), stages.end(), [&](const Stage& stage) { return stage.name == name; }); // there are only a handful of stages, so a search is fine
+	if (it != stages.end())
+		return static_cast<std::uint32_t>(it - stages.begin());
+
+	stages.emplace_back().name = name;
+	return static_cast<std::uint32_t>(stages.size() - 1);
+}
+
+TaskGraph::TaskID TaskGraph::Add(std::string_view stage, Task task, const std::span<const TaskID>& dependencies)
+{
+	bool isReady = false;
+	TaskID id = 0;
+	{
+		std::lock_guard<std::mutex> lockGuard(mutex);
+
+		id = static_cast<TaskID>(nodes.size());
+
+		Node& node = nodes.emplace_back();
+		node.task = std::move(task);
+		node.stage = GetStageIndex(stage);
+
+		for (TaskID dependency : dependencies)
+		{
+			Node& other = nodes[dependency];
+			if (other.isFinished)
+				continue;
+
+			other.dependents.push_back(id);
+			node.remainingDependencies++;
+		}
+
+		pendingCount++;
+
+		isReady = node.remainingDependencies == 0;
+		if (isReady)
+			readyTasks.push_back(id);
+	}
+
+	if (isReady)
+		taskAvailable.notify_one();
+
+	return id;
+}
+
+void TaskGraph::Wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	tasksCompleted.wait(lock, [&]() { return pendingCount == 0; });
+
+	if (exception != nullptr)
+		std::rethrow_exception(std::exchange(exception, nullptr));
+}
+
+std::vector<TaskGraph::StageStatistics> TaskGraph::GetStageStatistics() const
+{
+	std::lock_guard<std::mutex> lockGuard(mutex);
+
+	std::vector<StageStatistics> ret;
+	ret.reserve(stages.size());
+
+	for (const Stage& stage : stages)
+	{
+		StageStatistics& statistics = ret.emplace_back();
+		statistics.name = stage.name;
+		statistics.taskCount = stage.taskCount;
+		statistics.busyTime = std::chrono::duration<double, std::milli>(stage.busyTime).count();
+
+		if (stage.taskCount > 0)
+			statistics.wallTime = std::chrono::duration<double, std::milli>(stage.lastEnd - stage.firstStart).count();
+	}
+	return ret;
+}
+
+std::string TaskGraph::StageStatistics::ToString() const
+{
+	return std::format("{}: {} tasks, {:.1f} ms wall time, {:.1f} ms busy", name, taskCount, wallTime, busyTime);
+}
+
+void TaskGraph::Work()
+{
+	while (true)
+	{
+		TaskID id = 0;
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			taskAvailable.wait(lock, [&]() { return isStopping || !readyTasks.empty(); });
+
+			if (readyTasks.empty())
+				return;
+
+			id = readyTasks.front();
+			readyTasks.pop_front();
+
+			task = std::move(nodes[id].task);
+		}
+
+		Clock::time_point start = Clock::now();
+
+		std::exception_ptr taskException;
+		try
+		{
+			task();
+		}
+		catch (...) // the dependents still run, otherwise waiting on the graph would never return
+		{
+			taskException = std::current_exception();
+		}
+
+		Clock::time_point end = Clock::now();
+
+		std::size_t readyCount = 0;
+		bool isDone = false;
+		{
+			std::lock_guard<std::mutex> lockGuard(mutex);
+
+			Node& node = nodes[id];
+			node.isFinished = true;
+
+			Stage& stage = stages[node.stage];
+			stage.taskCount++;
+			stage.busyTime += end - start;
+			stage.firstStart = std::min(stage.firstStart, start);
+			stage.lastEnd = std::max(stage.lastEnd, end);
+
+			for (TaskID dependent : node.dependents)
+			{
+				if (--nodes[dependent].remainingDependencies != 0)
+					continue;
+
+				readyTasks.push_back(dependent);
+				readyCount++;
+			}
+
+			if (exception == nullptr)
+				exception = std::move(taskException);
+			taskException = nullptr; // released under the lock, since the exception can already be rethrown by a waiting thread
+
+			isDone = --pendingCount == 0;
+		}
+
+		if (readyCount == 1)
+			taskAvailable.notify_one();
+		else if (readyCount > 1)
+			taskAvailable.notify_all();
+
+		if (isDone)
+			tasksCompleted.notify_all();
+	}
+}
\ No newline at end of file
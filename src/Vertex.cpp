@@ -0,0 +1,154 @@
+module Renderer.Vertex;
+
+import <vulkan/vulkan.h>;
+
+import "glm.h";
+
+import std;
+
+// maps the unit vector onto an octahedron, which is then unfolded into a square of [-1, 1]
+static glm::vec2 EncodeOctahedral(const glm::vec3& vector)
+{
+	float sum = std::abs(vector.x) + std::abs(vector.y) + std::abs(vector.z);
+	if (sum == 0.0f) // a zero vector has no direction, this decodes to +Z
+		return glm::vec2(0.0f);
+
+	glm::vec3 projected = vector / sum;
+	if (projected.z >= 0.0f)
+		return glm::vec2(projected.x, projected.y);
+
+	// the lower half is folded over the diagonals
+	glm::vec2 sign(projected.x >= 0.0f ? 1.0f : -1.0f, projected.y >= 0.0f ? 1.0f : -1.0f);
+	return (1.0f - glm::abs(glm::vec2(projected.y, projected.x))) * sign;
+}
+
+bool Vertex::HasBones() const
+{
+	return std::any_of(std::begin(boneIndices), std::end(boneIndices), [](int index) { return index >= 0; });
+}
+
+PackedVertex PackedVertex::Pack(const Vertex& vertex)
+{
+	PackedVertex ret{};
+	ret.position[0] = vertex.position.x;
+	ret.position[1] = vertex.position.y;
+	ret.position[2] = vertex.position.z;
+
+	ret.normal = glm::packSnorm2x16(EncodeOctahedral(vertex.normal));
+	ret.textureCoordinates = glm::packHalf2x16(vertex.textureCoordinates);
+
+	// the bitangent is rebuilt from the normal and tangent, only its direction along their cross product is stored
+	bool isMirrored = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.biTangent) < 0.0f;
+	ret.tangent = (glm::packSnorm2x16(EncodeOctahedral(vertex.tangent)) & ~1u) | (isMirrored ? 1u : 0u);
+
+	return ret;
+}
+
+VkVertexInputBindingDescription PackedVertex::GetBindingDescription()
+{
+	VkVertexInputBindingDescription bindingDescription{};
+
+	bindingDescription.binding = 0;
+	bindingDescription.stride = sizeof(PackedVertex);
+	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	return bindingDescription;
+}
+
+std::array<VkVertexInputAttributeDescription, 4> PackedVertex::GetAttributeDescriptions()
+{
+	std::array<VkVertexInputAttributeDescription, 4> descriptions{};
+
+	descriptions[0].binding = 0;
+	descriptions[0].location = 0;
+	descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+	descriptions[0].offset = offsetof(PackedVertex, position);
+
+	// the normal and tangent are decoded by the shader, the fixed function formats cannot decode an octahedral vector
+	descriptions[1].binding = 0;
+	descriptions[1].location = 1;
+	descriptions[1].format = VK_FORMAT_R32_UINT;
+	descriptions[1].offset = offsetof(PackedVertex, normal);
+
+	descriptions[2].binding = 0;
+	descriptions[2].location = 2;
+	descriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+	descriptions[2].offset = offsetof(PackedVertex, textureCoordinates);
+
+	descriptions[3].binding = 0;
+	descriptions[3].location = 3;
+	descriptions[3].format = VK_FORMAT_R32_UINT;
+	descriptions[3].offset = offsetof(PackedVertex, tangent);
+
+	return descriptions;
+}
+
+SkinningData SkinningData::Pack(const Vertex& vertex)
+{
+	SkinningData ret{};
+
+	float totalWeight = 0.0f;
+	for (std::uint32_t i = 0; i < MAX_BONES_PER_VERTEX; i++)
+		if (vertex.boneIndices[i] >= 0 && vertex.boneIndices[i] < NO_BONE)
+			totalWeight += vertex.boneWeights[i];
+
+	if (totalWeight <= 0.0f)
+		return ret;
+
+	// the weights are renormalized, so that the bones that could not be packed do not shrink the vertex towards the origin
+	int remaining = 255;
+	std::uint32_t heaviest = 0;
+
+	for (std::uint32_t i = 0; i < MAX_BONES_PER_VERTEX; i++)
+	{
+		if (vertex.boneIndices[i] < 0 || vertex.boneIndices[i] >= NO_BONE)
+			continue;
+
+		int weight = static_cast<int>(std::round(vertex.boneWeights[i] / totalWeight * 255.0f));
+
+		ret.boneIndices[i] = static_cast<std::uint8_t>(vertex.boneIndices[i]);
+		ret.boneWeights[i] = static_cast<std::uint8_t>(std::clamp(weight, 0, 255));
+		remaining -= ret.boneWeights[i];
+
+		if (ret.boneWeights[i] > ret.boneWeights[heaviest] || ret.boneIndices[heaviest] == NO_BONE)
+			heaviest = i;
+	}
+
+	// rounding can make the weights miss 255 by a few, that is given to the heaviest bone where it matters the least
+	ret.boneWeights[heaviest] = static_cast<std::uint8_t>(std::clamp(ret.boneWeights[heaviest] + remaining, 0, 255));
+
+	return ret;
+}
+
+PackedMesh PackedMesh::Pack(const std::span<const Vertex>& vertices, const std::span<const std::uint32_t>& indices)
+{
+	PackedMesh ret{};
+	ret.vertices.resize(vertices.size());
+	std::transform(std::execution::par, vertices.begin(), vertices.end(), ret.vertices.begin(), PackedVertex::Pack);
+
+	if (std::any_of(std::execution::par, vertices.begin(), vertices.end(), [](const Vertex& vertex) { return vertex.HasBones(); }))
+	{
+		ret.skinning.resize(vertices.size());
+		std::transform(std::execution::par, vertices.begin(), vertices.end(), ret.skinning.begin(), SkinningData::Pack);
+	}
+
+	// a mesh that can address all of its vertices with 16 bits stores its indices as 16 bits, which halves their size
+	ret.indexType = vertices.size() <= std::numeric_limits<std::uint16_t>::max() + 1ULL ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+	if (ret.indexType == VK_INDEX_TYPE_UINT16)
+	{
+		ret.shortIndices.resize(indices.size());
+		std::transform(std::execution::par, indices.begin(), indices.end(), ret.shortIndices.begin(), [](std::uint32_t index) { return static_cast<std::uint16_t>(index); });
+	}
+	else
+	{
+		ret.indices.assign(indices.begin(), indices.end());
+	}
+
+	return ret;
+}
+
+std::size_t PackedMesh::GetIndexCount() const
+{
+	return indexType == VK_INDEX_TYPE_UINT16 ? shortIndices.size() : indices.size();
+}
\ No newline at end of file
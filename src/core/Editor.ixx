@@ -5,6 +5,7 @@ import "../glm.h";
 import std;
 
 import System.Window;
+import System.TaskGraph;
 
 import Physics.RigidBody;
 
@@ -22,6 +23,8 @@ import Core.Scene;
 import Core.Object;
 
 import IO.CreationData;
+import IO.ArchiveCache;
+import IO.ImportCache;
 
 namespace fs = std::filesystem;
 
@@ -135,8 +138,9 @@ private:
 
 	void ShowRigidBodyShape(RigidBody& rigid);
 
-	void LoadObjectsParallel(const std::span<const ObjectCreationData>& datas, float progressStep);
-	void LoadMaterialsParallel(const std::span<const std::variant<MaterialCreationData, MaterialCreateInfo>>& datas, float progressStep);
+	// every object and material is uploaded by its own task, the objects and materials are uploaded at the same time
+	void LoadObjectsParallel(TaskGraph& graph, const std::span<const ObjectCreationData>& datas, float progressStep);
+	void LoadMaterialsParallel(TaskGraph& graph, const std::span<const std::variant<MaterialCreationData, MaterialCreateInfo>>& datas, float progressStep);
 	void LoadAnimationsParallel(const std::span<Animation>& animations, float progressStep);
 
 	void ShowAddObjectWindow();
@@ -146,9 +150,11 @@ private:
 	void InitializeProject();
 	void LoadProject();
 	void LoadFile(const fs::path& path);
+	void StreamFile(const fs::path& path);
 
 	static std::string GetFile(const char* desc, const char* type);
 	void BuildProject();
+	void BenchmarkArchiveCodecs();
 
 	void QueueMeshChange(Object* object);
 	void ApplyQueuedMeshChange();
@@ -161,7 +167,9 @@ private:
 	bool addObject = false;
 	bool loadFile = false;
 	bool save = false;
+	bool benchmarkCodecs = false;
 	bool showUI = true;
+	bool streamFiles = true; // if true, loaded files appear in the scene progressively instead of all at once
 
 	int mouseX = 0;
 	int mouseY = 0;
@@ -170,6 +178,9 @@ private:
 
 	EditorProject project;
 
+	std::shared_ptr<ArchiveCache> archiveCache; // kept between loads, so reloading the project does not have to decompress everything again
+	std::shared_ptr<ImportCache> importCache;   // keeps the converted source files on disk, so opening them again skips assimp
+
 	ProgressBar progressBar{};
 	MeshChangeData queuedMeshChange{};
 	ObjectSelectionData selectionData{};
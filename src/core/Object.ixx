@@ -113,7 +113,8 @@ public:
 	void TransferChild(Object* child, Object* destination); // this removes the child from this objects children and adds to the destinations children
 
 	std::vector<char> Serialize() const; // when serializing, the children of an object will be serialized by the object itself.
-	void Deserialize(const BinarySpan& stream); // assumes that the object is already the correct type, also assumes that the inheritType at the beginning of the stream is already read (a.k.a. 'GetInheritTypeFromStream(...)' is already called)
+	void SerializeDataIntoStream(BinaryStream& stream) const; // only serializes the data of the object type, without the header, name and transform
+	void Deserialize(const BinarySpan& stream); // reads data written by Serialize, assumes that the object is already the correct type (see 'GetInheritTypeFromStream(...)', which has to be given its own BinarySpan)
 
 	static bool DeserializeIntoCreationData(const BinarySpan& stream, ObjectCreationData& ret);
 
@@ -146,15 +147,6 @@ public:
 	T& As() { return dynamic_cast<T&>(*this); }
 
 private:
-	void SerializeHeader(BinaryStream& stream) const;
-	void SerializeName(BinaryStream& stream) const;
-	void SerializeTransform(BinaryStream& stream) const;
-
-	void SerializeChildren(BinaryStream& stream) const;
-
-	void DeserializeName(const BinarySpan& stream);
-	void DeserializeTransform(const BinarySpan& stream);
-
 	void SerializeIntoStream(BinaryStream& stream) const;
 
 	void FreeSelf();
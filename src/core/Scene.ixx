@@ -8,6 +8,7 @@ import Core.CameraObject;
 import Core.Object;
 
 import IO.CreationData;
+import IO.SceneStream;
 
 import System.CriticalSection;
 
@@ -24,6 +25,14 @@ public:
 
 	bool HasFinishedLoading();
 
+	/// <summary>
+	/// Adds the objects and materials of a scene that is still loading over multiple frames, instead of all at once.
+	/// A stream that was still being added is dropped, the objects it already added stay in the scene
+	/// </summary>
+	void StreamFrom(std::shared_ptr<SceneStream> newStream);
+	void IntegrateStream(float budget); // adds streamed data for at most 'budget' milliseconds per call, the engine calls this every frame from the main thread
+	bool IsStreaming() const;
+
 	void UpdateCamera(Window* pWindow, float delta);
 	void UpdateScripts(float delta);
 	void CollectGarbage();
@@ -62,6 +71,8 @@ private:
 
 	bool sceneIsLoading = false;
 
+	std::shared_ptr<SceneStream> stream;
+
 protected:
 	void Free(Object* object);
 
@@ -400,6 +400,8 @@ void GUI::ShowDebugWindow(Profiler* profiler)
 		ShowChartGraph(Renderer::g_vertexBuffer.GetSize() / 1024ULL, Renderer::g_vertexBuffer.GetMaxSize() / 1024ULL, "vertex (kb)");
 		ImGui::SameLine();
 		ShowChartGraph(Renderer::g_defaultVertexBuffer.GetSize() / 1024ULL, Renderer::g_defaultVertexBuffer.GetMaxSize() / 1024ULL, "d_vertex (kb)");
+		ImGui::SameLine();
+		ShowChartGraph(Renderer::g_index16Buffer.GetSize() / 1024ULL, Renderer::g_index16Buffer.GetMaxSize() / 1024ULL, "index16 (kb)");
 
 		float scale = Renderer::internalScale;
 		ImGui::Text("Internal resolution:");
@@ -0,0 +1,54 @@
+export module IO.ArchiveCache;
+
+import std;
+
+/// <summary>
+/// A least recently used cache of decompressed archive data, bounded by a budget in bytes.
+/// The data is keyed by its content hash instead of its identifier, so the cache can be shared by multiple archives and stays valid when an archive is reopened or rewritten
+/// </summary>
+export class ArchiveCache
+{
+public:
+	struct Statistics
+	{
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+		std::uint64_t evictions = 0;
+
+		std::uint64_t size = 0;   // the amount of bytes currently in the cache
+		std::uint64_t budget = 0; // the maximum amount of bytes in the cache
+
+		float GetHitRate() const;
+	};
+
+	ArchiveCache(std::uint64_t budget);
+
+	ArchiveCache(const ArchiveCache&) = delete;
+	ArchiveCache& operator=(const ArchiveCache&) = delete;
+
+	// returns nullptr if the data is not in the cache, this counts as a miss
+	std::shared_ptr<const std::vector<char>> Find(std::uint64_t hash, std::uint64_t size);
+
+	// evicts the least recently used data until the new data fits, data larger than the budget is never cached
+	void Insert(std::uint64_t hash, std::shared_ptr<const std::vector<char>> data);
+
+	void Clear();
+
+	Statistics GetStatistics() const;
+	void ResetStatistics(); // only resets the counters, not the cached data
+
+private:
+	struct Entry
+	{
+		std::uint64_t hash = 0;
+		std::shared_ptr<const std::vector<char>> data;
+	};
+
+	void Evict(std::uint64_t required);
+
+	std::list<Entry> entries; // the most recently used entry is in the front
+	std::unordered_map<std::uint64_t, std::list<Entry>::iterator> lookup;
+
+	Statistics statistics{};
+	mutable std::mutex mutex; // multiple threads can read from the same archive at once
+};
\ No newline at end of file
@@ -5,6 +5,10 @@ import std;
 template<typename T>
 concept PrimitiveOnly = std::is_fundamental_v<T>;
 
+// any contiguous range of trivially copyable values can be copied as a whole, like a vector of vertices or a span of matrices
+template<typename T>
+concept TriviallyCopyableRange = std::ranges::contiguous_range<T> && std::ranges::sized_range<T> && std::is_trivially_copyable_v<std::ranges::range_value_t<T>>;
+
 export class BinaryStream
 {
 public:
@@ -32,8 +36,27 @@ public:
 		return *this;
 	}
 
+	/// <summary>
+	/// appends the entire range with a single copy, instead of writing every element on its own
+	/// </summary>
+	template<TriviallyCopyableRange Range>
+	void WriteRange(const Range& range)
+	{
+		Write(reinterpret_cast<const char*>(std::ranges::data(range)), std::ranges::size(range) * sizeof(std::ranges::range_value_t<Range>));
+	}
+
+	/// <summary>
+	/// fills the entire range with a single copy, the range must already have the size that should be read
+	/// </summary>
+	template<TriviallyCopyableRange Range>
+	void ReadRange(Range& range)
+	{
+		Read(reinterpret_cast<char*>(std::ranges::data(range)), std::ranges::size(range) * sizeof(std::ranges::range_value_t<Range>));
+	}
+
 	void Read(char* dst, size_t count);
 	void Write(const char* src, size_t count); // appends
+	void Reserve(std::size_t additionalSize); // makes sure that additionalSize more bytes can be written without reallocating, the capacity grows geometrically
 	void Clear();
 
 	std::vector<char> data;
@@ -62,6 +85,12 @@ public:
 		return *this;
 	}
 
+	template<TriviallyCopyableRange Range>
+	void ReadRange(Range& range) const
+	{
+		Read(reinterpret_cast<char*>(std::ranges::data(range)), std::ranges::size(range) * sizeof(std::ranges::range_value_t<Range>));
+	}
+
 	void Read(char* dst, std::size_t count) const;
 
 	std::span<const char> data;
@@ -0,0 +1,91 @@
+module;
+
+#include <zstd/zstd.h>
+
+export module IO.Compression;
+
+import std;
+
+export enum class CompressionCodec : std::uint8_t
+{
+	Store = 0, //!< the data is stored as is, useful for data that is already compressed
+	LZ4   = 1, //!< fast compression and very fast decompression, best for small and frequently read data
+	LZ4HC = 2, //!< slow compression, but decompresses as fast as LZ4 with a better ratio
+	Zstd  = 3, //!< the best ratio, but the slowest to decompress. best for large data that is rarely read
+	CodecCount = 4, // increment when a new codec is added
+};
+
+export struct CodecBenchmark
+{
+	CompressionCodec codec = CompressionCodec::Store;
+	int level = 0;
+
+	std::uint64_t uncompressedSize = 0;
+	std::uint64_t compressedSize = 0;
+
+	double compressionTime = 0.0;   // in seconds
+	double decompressionTime = 0.0; // in seconds
+
+	float GetRatio() const;
+	float GetCompressionSpeed() const;   // in MB/s
+	float GetDecompressionSpeed() const; // in MB/s
+};
+
+/// <summary>
+/// A dictionary trained on many small pieces of similar data. Data that is too small to compress well on its own compresses a lot better with a dictionary,
+/// but the exact same dictionary is needed to decompress it again
+/// </summary>
+export class CompressionDictionary
+{
+public:
+	CompressionDictionary(std::vector<char> data);
+	~CompressionDictionary();
+
+	CompressionDictionary(const CompressionDictionary&) = delete;
+	CompressionDictionary& operator=(const CompressionDictionary&) = delete;
+
+	std::span<const char> GetData() const;
+	const ZSTD_DDict* GetZstdDictionary() const; // the dictionary is only digested once, instead of every time a small piece of data is decompressed
+
+private:
+	std::vector<char> data;
+	ZSTD_DDict* zstdDictionary = nullptr;
+};
+
+export namespace Compression
+{
+	constexpr std::size_t DEFAULT_DICTIONARY_SIZE = 16 * 1024;
+
+	std::string_view CodecToString(CompressionCodec codec);
+
+	/// <summary>
+	/// compresses the data with the given codec
+	/// </summary>
+	/// <param name="src">the data to compress</param>
+	/// <param name="codec">the codec to compress with</param>
+	/// <param name="level">the level of compression, 0 will pick the default level of the codec</param>
+	/// <param name="pDictionary">the dictionary to compress with, the same dictionary has to be given when decompressing</param>
+	/// <returns>the compressed data, or an empty vector if the data cannot be compressed to something smaller than the original</returns>
+	extern std::vector<char> Compress(const std::span<const char>& src, CompressionCodec codec, int level = 0, const CompressionDictionary* pDictionary = nullptr);
+
+	/// <summary>
+	/// decompresses the data into dst, dst must be exactly the size of the uncompressed data
+	/// </summary>
+	/// <returns>true if the data has been successfully decompressed, otherwise false</returns>
+	extern bool Decompress(const std::span<const char>& src, const std::span<char>& dst, CompressionCodec codec, const CompressionDictionary* pDictionary = nullptr);
+
+	/// <summary>
+	/// trains a dictionary on the given samples. the dictionary is trained for Zstd, but LZ4 can use it as well
+	/// </summary>
+	/// <param name="samples">small pieces of data that are representative of the data that will be compressed with the dictionary</param>
+	/// <param name="maxSize">the maximum size of the dictionary</param>
+	/// <returns>the dictionary, or an empty vector if there are not enough samples to train a dictionary with</returns>
+	extern std::vector<char> TrainDictionary(const std::vector<std::span<const char>>& samples, std::size_t maxSize = DEFAULT_DICTIONARY_SIZE);
+
+	extern std::vector<CodecBenchmark> GetBenchmarkCodecs(); // returns the codecs and levels that are compared in a benchmark
+
+	/// <summary>
+	/// compresses and decompresses the sample with every codec in results and adds the sizes and timings to the results
+	/// </summary>
+	extern void Benchmark(const std::span<const char>& sample, std::vector<CodecBenchmark>& results);
+}
\ No newline at end of file
@@ -10,16 +10,35 @@ import Physics.Shapes;
 import Renderer.Light;
 import Renderer.Vertex;
 
+import IO.Reflection;
+
+// the version of every creation data type, the types are nested in each other so they share a version
+export constexpr std::uint32_t CREATION_DATA_VERSION = 1;
+
 export struct ImageCreationData
 {
 	std::vector<char> data;
 
+	std::span<const char> view;            // the texture as it is read from an archive, this is used instead of data if it is not empty
+	std::shared_ptr<const void> viewOwner; // keeps the memory of the view alive
+
+	std::span<const char> GetData() const
+	{
+		return view.empty() ? std::span<const char>(data) : view;
+	}
+
 	bool IsDefault() const
 	{
-		return data.empty();
+		return data.empty() && view.empty();
 	}
 };
 
+template<> struct Reflection::Schema<ImageCreationData>
+{
+	static constexpr std::uint32_t version = CREATION_DATA_VERSION;
+	static constexpr auto fields = std::tuple{ Field{ &ImageCreationData::data } };
+};
+
 export struct MaterialCreationData
 {
 	bool isLight = false;
@@ -36,6 +55,21 @@ export struct MaterialCreationData
 	}
 };
 
+// version 0 is the layout of the materials in older archives, which had no metallic texture
+template<> struct Reflection::Schema<MaterialCreationData>
+{
+	static constexpr std::uint32_t version = CREATION_DATA_VERSION;
+	static constexpr auto fields = std::tuple
+	{
+		Field{ &MaterialCreationData::albedo },
+		Field{ &MaterialCreationData::normal },
+		Field{ &MaterialCreationData::metallic, 1 },
+		Field{ &MaterialCreationData::roughness },
+		Field{ &MaterialCreationData::ambientOccl },
+		Field{ &MaterialCreationData::isLight, 1 },
+	};
+};
+
 export struct MeshCreationData
 {
 	std::uint32_t materialIndex;
@@ -55,6 +89,24 @@ export struct MeshCreationData
 	std::vector<uint32_t> indices;
 };
 
+template<> struct Reflection::Schema<MeshCreationData>
+{
+	static constexpr std::uint32_t version = CREATION_DATA_VERSION;
+	static constexpr auto fields = std::tuple
+	{
+		Field{ &MeshCreationData::materialIndex, 1 },
+		Field{ &MeshCreationData::hasBones, 1 },
+		Field{ &MeshCreationData::hasMaterial, 1 },
+		Field{ &MeshCreationData::cullBackFaces, 1 },
+		Field{ &MeshCreationData::min, 1 },
+		Field{ &MeshCreationData::max, 1 },
+		Field{ &MeshCreationData::faceCount, 1 },
+		Field{ &MeshCreationData::flags, 1 },
+		Field{ &MeshCreationData::vertices, 1 }, // the vertices and indices are copied as a whole
+		Field{ &MeshCreationData::indices, 1 },
+	};
+};
+
 export struct RigidCreationData
 {
 	glm::vec3 extents = glm::vec3(0);
@@ -63,6 +115,27 @@ export struct RigidCreationData
 	RigidBody::Type rigidType = RigidBody::Type::None;
 };
 
+template<> struct Reflection::Schema<RigidCreationData>
+{
+	static constexpr std::uint32_t version = CREATION_DATA_VERSION;
+	static constexpr auto fields = std::tuple{ Field{ &RigidCreationData::extents, 1 }, Field{ &RigidCreationData::shapeType, 1 }, Field{ &RigidCreationData::rigidType, 1 } };
+};
+
+template<> struct Reflection::Schema<Light>
+{
+	static constexpr std::uint32_t version = CREATION_DATA_VERSION;
+	static constexpr auto fields = std::tuple
+	{
+		Field{ &Light::name, 1 },
+		Field{ &Light::cutoff, 1 },
+		Field{ &Light::outerCutoff, 1 },
+		Field{ &Light::pos, 1 },
+		Field{ &Light::color, 1 },
+		Field{ &Light::direction, 1 },
+		Field{ &Light::type, 1 },
+	};
+};
+
 export struct ObjectCreationData
 {
 	enum class Type
@@ -92,4 +165,25 @@ export struct ObjectCreationData
 
 	std::vector<ObjectCreationData> children;
 	std::vector<char> unknownData; // unknown refers to data of which its purpose is unknown, this data can be used for i.e. superclasses that inherit from Objects (de)serialization pipeline
+};
+
+// version 0 is the header of the objects in older archives, which is followed by the data of the object type instead of the other fields
+template<> struct Reflection::Schema<ObjectCreationData>
+{
+	static constexpr std::uint32_t version = CREATION_DATA_VERSION;
+	static constexpr auto fields = std::tuple
+	{
+		Field{ &ObjectCreationData::type },
+		Field{ &ObjectCreationData::name },
+		Field{ &ObjectCreationData::position },
+		Field{ &ObjectCreationData::scale },
+		Field{ &ObjectCreationData::rotation },
+		Field{ &ObjectCreationData::state, 1 },
+		Field{ &ObjectCreationData::hitBox, 1 },
+		Field{ &ObjectCreationData::hasMesh, 1 },
+		Field{ &ObjectCreationData::mesh, 1 },
+		Field{ &ObjectCreationData::lightData, 1 },
+		Field{ &ObjectCreationData::children, 1 },
+		Field{ &ObjectCreationData::unknownData, 1 },
+	};
 };
\ No newline at end of file
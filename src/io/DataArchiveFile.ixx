@@ -3,31 +3,79 @@ export module IO.DataArchiveFile;
 import std;
 
 import IO.ReadWriteFile;
+import IO.FileMapping;
+import IO.Compression;
+import IO.ArchiveCache;
+import IO.Hash;
+
+/// <summary>
+/// the key an identifier is stored under in the archive, which is a 64 bit hash of the identifier.
+/// creating a key never allocates, so looking up an entry only costs hashing the identifier
+/// </summary>
+export struct ArchiveKey
+{
+	constexpr ArchiveKey(std::string_view identifier) : hash(Hash::FNV1a(identifier)) {}
+	constexpr ArchiveKey(const char* identifier) : ArchiveKey(std::string_view(identifier)) {}
+	constexpr ArchiveKey(const std::string& identifier) : ArchiveKey(std::string_view(identifier)) {}
+
+	static constexpr ArchiveKey FromHash(std::uint64_t hash)
+	{
+		ArchiveKey ret("");
+		ret.hash = hash;
+		return ret;
+	}
+
+	constexpr ArchiveKey Append(std::string_view suffix) const // gives the key of the identifier followed by the suffix, without building that identifier
+	{
+		ArchiveKey ret = *this;
+		ret.hash = Hash::FNV1a(suffix, hash);
+		return ret;
+	}
+
+	constexpr bool operator==(const ArchiveKey& other) const = default;
+
+	std::uint64_t hash = 0;
+};
 
 export class DataArchiveFile
 {
 private:
+	enum EntryFlags : std::uint32_t
+	{
+		EntryFlagNone = 0,
+		EntryFlagChunked = 1 << 0,    //!< the data is split into chunks that are compressed independently of each other
+		EntryFlagDictionary = 1 << 1, //!< the data is compressed with the compression dictionary of the archive
+	};
+
 	struct Metadata
 	{
 		bool isOnDisk = true;
 
 		std::uint64_t offset = 0;
 		std::uint64_t size = 0;
-		std::uint64_t uncompressedSize = 0; // this is only used for data that isnt written to the disk yet
-		std::vector<char> compressed;
+		std::uint64_t uncompressedSize = 0; // this is unknown for entries read from archives that predate the footer
+		std::uint64_t hash = 0;             // hash of the uncompressed data, used to detect if the data has changed
+		std::uint32_t flags = EntryFlagNone;
+		CompressionCodec codec = CompressionCodec::LZ4;
+		std::int8_t level = 0;
+		std::uint64_t sequence = 0; // when the entry was added in this session, 0 for entries that were read from disk. entries are laid out on disk in this order
+		std::shared_ptr<const std::vector<char>> compressed; // shared between identifiers that hold the same data
 	};
 
+	struct EntryRecord; // the fixed size form of the metadata on disk
+
 public:
 	struct DataEntry
 	{
-		std::string_view identifier; // valid string as long as the DataArchiveFile is alive
+		ArchiveKey key;
+		std::string_view identifier; // valid string as long as the DataArchiveFile is alive, this is empty if the archive has no name for the key
 		std::vector<char> data;      // data will be empty if the read has failed
 	};
 
 	class Iterator
 	{
 	public:
-		Iterator(const std::map<std::string, Metadata>::iterator& it, DataArchiveFile& parent);
+		Iterator(const std::unordered_map<std::uint64_t, Metadata>::iterator& it, DataArchiveFile& parent);
 
 		Iterator operator++();
 
@@ -37,7 +85,7 @@ public:
 		DataEntry operator*() const;
 
 	private:
-		std::map<std::string, Metadata>::iterator internal;
+		std::unordered_map<std::uint64_t, Metadata>::iterator internal;
 
 		DataArchiveFile& parent;
 	};
@@ -46,6 +94,7 @@ public:
 	{
 		Clear = ReadWriteFile::OpenMethod::Clear,  //!< clear the file upon opening
 		Append = ReadWriteFile::OpenMethod::Append, //!< do not clear the file
+		ReadOnly, //!< map the entire file into memory once, the archive cannot be written to
 	};
 
 	enum Result
@@ -54,52 +103,272 @@ public:
 		IdentifierNotFound,
 		DecompressionFailed,
 		InvalidReference, //!< the data pointing to the data associated with the identifier is not valid (i.e. out of bounds)
+		NotMapped,        //!< the archive is not opened with OpenMethod::ReadOnly
+		IsCompressed,     //!< the data is compressed and cannot be viewed directly
+		BufferTooSmall,   //!< the given buffer cannot hold all of the data
+		KeyCollision,     //!< another identifier already has the same key, the data is not added
+	};
+
+	struct ReadStatistics
+	{
+		std::uint64_t sequentialReads = 0; // reads that started at or right after the end of the previous read
+		std::uint64_t randomReads = 0;     // reads that had to seek to another part of the file
+		std::uint64_t bytesRead = 0;
 	};
 
 	/// <summary>
-	/// Opens a file and expects it can be written to and read from
+	/// a buffer borrowed from the archive, which is given back when this is destroyed so that later reads can reuse its memory.
+	/// this must not outlive the archive it is borrowed from
+	/// </summary>
+	class PooledBuffer
+	{
+	public:
+		PooledBuffer(const DataArchiveFile& parent, std::vector<char>&& buffer);
+		PooledBuffer(PooledBuffer&& other) noexcept;
+		~PooledBuffer();
+
+		PooledBuffer(const PooledBuffer&) = delete;
+		PooledBuffer& operator=(const PooledBuffer&) = delete;
+		PooledBuffer& operator=(PooledBuffer&&) = delete;
+
+		std::span<const char> GetData() const;
+
+	private:
+		friend class DataArchiveFile;
+
+		const DataArchiveFile* pParent = nullptr;
+		std::vector<char> buffer;
+	};
+
+	/// <summary>
+	/// the data of an entry read by ReadEntry or ReadBatch. the data is a view into the mapping if the entry is stored as is in a mapped archive,
+	/// otherwise it is decompressed into the pooled buffer owned by this. this must not outlive the archive it is read from
+	/// </summary>
+	struct EntryView
+	{
+		std::optional<PooledBuffer> storage;
+		std::span<const char> data;
+	};
+
+	using BatchRead = std::function<void()>;
+	using BatchCallback = std::function<void(std::size_t index, std::expected<EntryView, Result>&& entry)>; // the index is the index of the key in the batch
+	using BatchExecutor = std::function<void(BatchRead read)>;
+
+	/// <summary>
+	/// Opens a file and expects it can be written to and read from.
+	/// The archive is append-only: new data is added to the end of the file, followed by a new dictionary and a footer pointing to that dictionary
 	/// </summary>
 	/// <param name="file">the path to the file to open</param>
 	/// <param name="method">the attribute to open the file with</param>
 	DataArchiveFile(const std::string& file, OpenMethod method);
+	~DataArchiveFile(); // writes the dictionary if the archive is still streaming
 
 	/// <summary>
-	/// Adds data to the archive. This will override any data that the identifier could already be holding
+	/// Adds data to the archive. This will override any data that the identifier could already be holding.
+	/// If any identifier already holds the exact same data, that data is shared between the identifiers and is only stored once.
+	/// The identifier itself is only stored in the name table (see SetStoreNames), the entry is found by its key.
+	/// The data is written to disk in the order it is added, so adding data in the order it is read keeps loading from a cold disk sequential
 	/// </summary>
 	/// <param name="identifier">the identifier to associate the data with</param>
 	/// <param name="data">the data that should be bound to the identifier</param>
-	void AddData(const std::string& identifier, const std::span<char const>& data);
+	/// <param name="codec">the codec to compress the data with. LZ4 is best for small data that is read often, LZ4HC and Zstd for large data and Store for data that is already compressed</param>
+	/// <param name="level">the level to compress the data with, 0 picks the default level of the codec</param>
+	/// <returns>Result::KeyCollision if another identifier with the same key is known to the archive, otherwise Result::Success</returns>
+	Result AddData(std::string_view identifier, const std::span<char const>& data, CompressionCodec codec = CompressionCodec::LZ4, int level = 0);
+
+	/// <summary>
+	/// sets the dictionary that small entries are compressed with (see Compression::TrainDictionary), this gives a much better ratio for many small entries with similar data.
+	/// entries that are compressed with the previous dictionary are recompressed with the new one. an empty dictionary removes the dictionary from the archive
+	/// </summary>
+	void SetCompressionDictionary(std::vector<char> data);
+
+	/// <returns>the dictionary that small entries are compressed with, or a nullptr if the archive has no dictionary</returns>
+	const CompressionDictionary* GetCompressionDictionary() const;
 
 	/// <summary>
-	/// reads the data of associated with the given identifier
+	/// reads the data of associated with the given identifier.
+	/// this can be called from multiple threads at once, as long as the dictionary isn't modified at the same time (i.e. by AddData or WriteToFile)
 	/// </summary>
-	/// <param name="identifier"></param>
+	/// <param name="key"></param>
 	/// <returns>if no error took place the data, otherwise an error code</returns>
-	std::expected<std::vector<char>, Result> ReadData(const std::string& identifier);
+	std::expected<std::vector<char>, Result> ReadData(ArchiveKey key) const;
+
+	/// <summary>
+	/// reads the data associated with the given identifier into dst, without allocating a buffer for the data. use GetUncompressedSize to find out how large dst must be
+	/// </summary>
+	/// <returns>if no error took place the part of dst that holds the data, otherwise an error code</returns>
+	std::expected<std::span<char>, Result> ReadDataInto(ArchiveKey key, const std::span<char>& dst) const;
+
+	/// <summary>
+	/// reads the data associated with the given identifier into a buffer that is recycled by the archive once it is destroyed.
+	/// this is meant for reading a lot of entries that are only needed for a short time
+	/// </summary>
+	std::expected<PooledBuffer, Result> ReadDataPooled(ArchiveKey key) const;
+
+	std::expected<std::uint64_t, Result> GetUncompressedSize(ArchiveKey key) const; // the exact amount of bytes that reading the identifier will give
+
+	/// <summary>
+	/// every read will first look for the data in the cache, and data that is not in the cache yet is added to it after it is read.
+	/// the cache can be shared with other archives and can outlive the archive, so that reopening the same archive does not have to decompress everything again
+	/// </summary>
+	/// <param name="cache">the cache to use, or nullptr to stop using a cache</param>
+	void SetCache(std::shared_ptr<ArchiveCache> cache);
+
+	/// <summary>
+	/// gives a view into the mapped archive of the data associated with the given identifier, no copies are made.
+	/// this only works for archives opened with OpenMethod::ReadOnly and for data that is stored uncompressed
+	/// </summary>
+	/// <param name="key"></param>
+	/// <returns>if no error took place a view of the data that is valid as long as the DataArchiveFile is alive, otherwise an error code</returns>
+	std::expected<std::span<const char>, Result> ReadView(ArchiveKey key) const;
+
+	/// <summary>
+	/// reads the data associated with the given identifier without copying it if possible, see EntryView
+	/// </summary>
+	std::expected<EntryView, Result> ReadEntry(ArchiveKey key) const;
+
+	/// <summary>
+	/// reads a batch of entries. the reads are started in the order the entries are laid out in the file, so a cold disk reads the batch front to back.
+	/// every read is handed to the executor, which keeps as many reads in flight as it has threads. a read decompresses its own entry and calls the callback
+	/// on the thread it ran on, so that reading, decompressing and consuming the entries overlap. the entries can complete in any order
+	/// </summary>
+	/// <param name="keys">the entries to read</param>
+	/// <param name="callback">called once for every key, this is copied and kept alive until the last read has finished</param>
+	/// <param name="executor">runs the reads, like a thread pool. this is only called before ReadBatch returns. without an executor every read runs on the calling thread, one after the other</param>
+	void ReadBatch(const std::span<const ArchiveKey>& keys, BatchCallback callback, const BatchExecutor& executor = {}) const;
 
 	bool IsValid() const;
-	bool HasEntry(const std::string& identifier) const;
+	bool IsReadOnly() const;
+	bool HasEntry(ArchiveKey key) const;
+
+	/// <summary>
+	/// sets whether the identifiers are written to the name table of the archive. the names are never needed to find an entry,
+	/// they only exist for debugging and for iterating over the archive. this is enabled by default
+	/// </summary>
+	void SetStoreNames(bool store);
+
+	std::string_view GetIdentifier(ArchiveKey key); // returns an empty string if the archive has no name for the key, the name table is loaded the first time this is called
 
-	void WriteToFile(); // writes the data that is only in RAM to disk, ignores any table entry thats already in the file
+	void WriteToFile(); // appends the data that is only in RAM to the file, followed by the new dictionary. data thats already in the file is not rewritten
+
+	/// <summary>
+	/// from now on every added entry is written to the file immediately, instead of being kept in RAM until WriteToFile is called.
+	/// this keeps the memory usage bounded no matter how much data is added. WriteToFile writes the dictionary and stops the streaming
+	/// </summary>
+	void StartStreaming();
+	bool IsStreaming() const;
+
+	/// <summary>
+	/// removes every identifier from the dictionary. the data on disk is remembered until the archive is closed,
+	/// so identifiers that are added again with unchanged data can still reuse it
+	/// </summary>
 	void ClearDictionary();
 
-	Iterator begin();
+	/// <summary>
+	/// rewrites the archive with only the data that is still referenced by the dictionary, this removes any data made unreachable by earlier writes
+	/// </summary>
+	void Compact();
+
+	std::uint64_t GetUnusedSize() const; // the amount of bytes in the file that are no longer referenced by the dictionary
+
+	ReadStatistics GetReadStatistics() const; // only counts the reads that go to the file, not those served by the cache or from RAM
+	void ResetReadStatistics();
+	std::uint64_t GetFileSize() const;
+
+	/// <summary>
+	/// dictionaries before version 5 are keyed by identifier and are hashed when they are loaded. an identifier whose key already belongs to another identifier is ignored,
+	/// the same way AddData refuses it with Result::KeyCollision
+	/// </summary>
+	/// <returns>the identifiers that were ignored while loading the dictionary</returns>
+	const std::vector<std::string>& GetCollidingIdentifiers() const;
+
+	std::vector<CodecBenchmark> BenchmarkCodecs() const; // compresses every entry with every benchmarked codec, useful for picking the codec of an entry
+
+	Iterator begin(); // loads the name table
 	Iterator end();
 
 private:
-	// the presence of the identifier is confirmed at this point, offset should be the offset from the start of the file
-	std::expected<std::vector<char>, Result> ReadFromDisk(std::uint64_t offset, std::uint64_t size);
-	std::uint64_t GetBinarySizeOfDictionary() const;
+	std::expected<std::vector<char>, Result> ReadData(const Metadata& metadata) const;
+	Result ReadDataInto(const Metadata& metadata, const std::span<char>& dst) const; // dst must be exactly the uncompressed size
+	Result ReadUncachedDataInto(const Metadata& metadata, const std::span<char>& dst) const;
+	std::expected<std::uint64_t, Result> GetUncompressedSize(const Metadata& metadata) const;
+
+	// the presence of the identifier is confirmed at this point
+	Result ReadFromDisk(const Metadata& metadata, const std::span<char>& dst) const;
+
+	void RecordRead(const Metadata& metadata) const; // updates the read statistics
+
+	std::vector<char> AcquireBuffer() const; // takes a buffer from the pool, the buffer is empty but can have capacity left from an earlier read
+	void ReleaseBuffer(std::vector<char>&& buffer) const;
+
+	const CompressionDictionary* GetCompressionDictionary(const Metadata& metadata) const; // returns nullptr if the data is not compressed with the dictionary
+	void LoadCompressionDictionary();
+
+	// returns the compressed data of an entry inside the mapping and its uncompressed size
+	std::expected<std::span<const char>, Result> GetMappedEntry(const Metadata& metadata, std::uint64_t& uncompressedSize) const;
+
+	// returns the metadata of data (on disk or not) that is identical to the given data and compressed the same way, or a nullptr if no such data exists
+	const Metadata* FindReusableEntry(std::uint64_t key, std::uint64_t hash, const std::span<char const>& data, CompressionCodec codec, bool useDictionary) const;
+	bool HoldsData(const Metadata& metadata, const std::span<char const>& data) const; // compares the stored data byte for byte
+
+	void AddEntry(std::uint64_t key, const std::span<char const>& data, CompressionCodec codec, int level);
+
+	void LoadNames(); // namesMutex has to be locked
+	void UpdateNameTable(); // serializes the names of the current entries, the name table is only rewritten if it changed
 
-	// these two functions should always be called together, as 'WriteDictionaryToDisk()' calculates parameters that 'WriteDataEntriesToDisk()' requires
-	void WriteDictionaryToDisk();
-	void WriteDataEntriesToDisk();
+	void WriteDataEntriesToDisk(const ReadWriteFile& file);
+	void WriteEntryToDisk(const ReadWriteFile& file, Metadata& metadata, const std::span<const char>& data) const; // writes the data at the current position of the file and marks the entry as on disk
+	std::uint64_t WriteDictionaryToDisk(const ReadWriteFile& file, const std::unordered_map<std::uint64_t, Metadata>& entries, const Metadata& compressionDictionaryEntry, const Metadata& nameTableEntry) const; // writes the dictionary and the footer at the current position of the file, returns the amount of bytes written
 
 	void ReadDictionaryFromDisk();
+	void ReadLegacyDictionaryFromDisk();
+	void ReadDictionaryFromMapping();
+	void ReadDictionary(const std::span<const char>& data, std::uint32_t version); // version 0 refers to the dictionary at the start of the file, which was used before the footer existed
+	void ReadHashedDictionary(const std::span<const char>& data);
+	bool AddIdentifiedEntry(std::string identifier, const Metadata& metadata); // for dictionaries that store the identifiers, returns false if the key collides with another identifier
 
-	static std::expected<std::vector<char>, Result> DecompressMemory(const std::span<char const>& compressed, std::uint64_t uncompressedSize);
-	static std::vector<char> CompressMemory(const std::span<char const>& uncompressed);
+	static EntryRecord ToRecord(std::uint64_t key, const Metadata& metadata);
+	static Metadata FromRecord(const EntryRecord& record);
 
-	std::map<std::string, Metadata> dictionary;
+	static Result DecompressInto(const std::span<char const>& compressed, const std::span<char>& dst, std::uint32_t flags, CompressionCodec codec, const CompressionDictionary* pDictionary = nullptr); // dst must be exactly the uncompressed size
+	static std::vector<char> CompressMemory(const std::span<char const>& uncompressed, CompressionCodec& codec, int level, const CompressionDictionary* pDictionary = nullptr); // sets the codec to CompressionCodec::Store if the data cannot be compressed
+
+	// these split the data into chunks and (de)compress every chunk on its own thread
+	static Result DecompressChunked(const std::span<char const>& compressed, const std::span<char>& dst, CompressionCodec codec);
+	static std::vector<char> CompressChunked(const std::span<char const>& uncompressed, CompressionCodec codec, int level);
+
+	// these are keyed by ArchiveKey::hash
+	std::unordered_map<std::uint64_t, Metadata> dictionary; // only read from after the file is opened, so reading threads can share it without locking
+	std::unordered_map<std::uint64_t, Metadata> reusable;   // entries that were removed from the dictionary, but whose data is still on disk
+	std::unordered_map<std::uint64_t, std::uint64_t> contents; // maps the hash of data to a key that held the data, the key might not hold it anymore
+	std::unordered_map<std::uint64_t, std::string> names;   // the identifiers of the keys, this is only complete after LoadNames. names are kept even if they are not stored, to find key collisions
+	std::string path;
 	ReadWriteFile stream;
+
+	std::uint64_t dictionarySize = 0; // the size of the dictionary and footer that are currently on disk
+
+	Metadata compressionDictionaryEntry{}; // where the compression dictionary is stored, the size is 0 if the archive has no compression dictionary
+	std::unique_ptr<CompressionDictionary> compressionDictionary;
+
+	Metadata nameTableEntry{}; // where the name table is stored, the size is 0 if the archive has no name table
+	bool namesLoaded = false;
+
+	std::vector<std::string> collidingIdentifiers;
+	mutable std::mutex namesMutex; // the names are loaded lazily, which can happen while other threads read the archive
+	bool storeNames = true;
+
+	std::unique_ptr<FileMapping> mapping; // only present if the archive is read only
+	std::unique_ptr<WriteSession> streamingSession; // only present while the archive is streaming
+
+	std::shared_ptr<ArchiveCache> cache; // optional
+
+	std::uint64_t nextSequence = 1;
+
+	mutable std::atomic<std::uint64_t> lastReadEnd = 0; // where the previous read from the file ended
+	mutable std::atomic<std::uint64_t> sequentialReads = 0;
+	mutable std::atomic<std::uint64_t> randomReads = 0;
+	mutable std::atomic<std::uint64_t> bytesRead = 0;
+
+	mutable std::vector<std::vector<char>> bufferPool; // scratch buffers that are reused between reads
+	mutable std::mutex bufferPoolMutex;
 };
\ No newline at end of file
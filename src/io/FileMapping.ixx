@@ -0,0 +1,27 @@
+export module IO.FileMapping;
+
+import std;
+
+/// <summary>
+/// Maps an entire file into memory as read-only. The view stays valid for as long as the mapping is alive.
+/// </summary>
+export class FileMapping
+{
+public:
+	FileMapping(const std::string_view& file);
+	~FileMapping();
+
+	FileMapping(const FileMapping&) = delete;
+	FileMapping& operator=(const FileMapping&) = delete;
+
+	bool IsValid() const;
+
+	std::span<const char> GetView() const;
+	std::size_t GetSize() const;
+
+private:
+	const char* view = nullptr;
+	std::size_t size = 0;
+
+	bool valid = false;
+};
\ No newline at end of file
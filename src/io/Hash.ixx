@@ -0,0 +1,34 @@
+export module IO.Hash;
+
+import std;
+
+export namespace Hash
+{
+	/// <summary>
+	/// hashes the given data with the 64 bit variant of xxHash
+	/// </summary>
+	/// <param name="data">the data to hash</param>
+	/// <param name="seed">the seed to start the hash with</param>
+	/// <returns>the 64 bit hash of the data</returns>
+	extern std::uint64_t XXH64(const std::span<const char>& data, std::uint64_t seed = 0);
+
+	constexpr std::uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ULL;
+	constexpr std::uint64_t FNV1A_PRIME = 1099511628211ULL;
+
+	/// <summary>
+	/// hashes the given string with the 64 bit variant of FNV-1a. this is a lot weaker than XXH64, but it works on strings of any length at compile time
+	/// and the hash of a concatenated string can be continued from the hash of its first part
+	/// </summary>
+	/// <param name="data">the string to hash</param>
+	/// <param name="hash">the hash to continue from, the hash of the string that comes before data</param>
+	/// <returns>the 64 bit hash of the string</returns>
+	constexpr std::uint64_t FNV1a(std::string_view data, std::uint64_t hash = FNV1A_OFFSET_BASIS)
+	{
+		for (char c : data)
+		{
+			hash ^= static_cast<std::uint8_t>(c);
+			hash *= FNV1A_PRIME;
+		}
+		return hash;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+export module IO.ImportCache;
+
+import std;
+
+import IO.CreationData;
+
+import Renderer.Material;
+
+namespace fs = std::filesystem;
+
+/// <summary>
+/// An on-disk cache of converted source scenes (like .fbx, .gltf or .obj files), so that opening an unchanged file again skips the import and conversion.
+/// Every entry is a file in the cache directory, named after its key. The key is the hash of the contents of the source file, the import flags and the version of the conversion,
+/// so a changed file, different flags or a newer engine all miss the cache instead of reading stale data
+/// </summary>
+export class ImportCache
+{
+public:
+	static constexpr std::uint32_t VERSION = 2; // increase this whenever the conversion of an imported scene changes
+
+	struct Key
+	{
+		std::uint64_t contentHash = 0;
+		std::uint32_t importFlags = 0;
+		std::uint32_t version = 0; // the version of the cache combined with the version of the creation data
+
+		std::string ToFileName() const;
+
+		bool operator==(const Key&) const = default;
+	};
+
+	struct Contents
+	{
+		std::vector<ObjectCreationData> objects;
+		std::vector<MaterialCreateInfo> materials;
+		std::uint64_t objectCount = 0; // the amount of objects including all children
+	};
+
+	ImportCache(const fs::path& directory); // the directory is created when the first entry is stored
+
+	ImportCache(const ImportCache&) = delete;
+	ImportCache& operator=(const ImportCache&) = delete;
+
+	/// <summary>
+	/// creates the key of a source file by hashing all of its contents
+	/// </summary>
+	/// <returns>nothing if the file cannot be read</returns>
+	static std::optional<Key> CreateKey(const fs::path& source, std::uint32_t importFlags);
+
+	/// <summary>
+	/// reads the entry of the key. the texture paths inside the directory of the source file are stored relative to it, so the entry stays valid if the source is moved along with its textures
+	/// </summary>
+	/// <param name="baseDirectory">the directory of the source file, the texture paths are made relative to this again</param>
+	/// <returns>nothing if there is no entry for the key or if the entry is damaged</returns>
+	std::optional<Contents> Find(const Key& key, const fs::path& baseDirectory) const;
+
+	/// <summary>
+	/// writes an entry for the key, replacing any existing entry. the entry is first written to a temporary file, so a reader never sees a half written entry
+	/// </summary>
+	/// <returns>false if the entry could not be written</returns>
+	bool Store(const Key& key, const std::span<const ObjectCreationData>& objects, const std::span<const MaterialCreateInfo>& materials, std::uint64_t objectCount, const fs::path& baseDirectory) const;
+
+private:
+	fs::path directory;
+};
\ No newline at end of file
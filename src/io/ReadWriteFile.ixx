@@ -2,8 +2,10 @@ export module IO.ReadWriteFile;
 
 import std;
 
-using HANDLE = void*;
-
+/// <summary>
+/// A file that is opened once and then read from and written to with positional I/O. The file pointer is kept by the object itself,
+/// so 'Read' and 'Write' are positional as well and 'ReadAt' and 'WriteAt' never disturb it. Works on Windows and on POSIX systems
+/// </summary>
 export class ReadWriteFile
 {
 public:
@@ -20,13 +22,38 @@ public:
 		Append,
 	};
 
-	ReadWriteFile(const std::string_view& file, OpenMethod method);
+	enum class AccessHint // tells the OS how the file is going to be read, so that it can read ahead or stop doing so
+	{
+		Normal,
+		Sequential,
+		Random,
+	};
+
+	/// <param name="file">the path of the file, it is created if it does not exist yet</param>
+	/// <param name="method">Clear empties the file when it is opened</param>
+	/// <param name="hint">how the file will be accessed</param>
+	/// <param name="unbuffered">if true, 'ReadAt' reads around the OS file cache. this is meant for large files that are only read once</param>
+	ReadWriteFile(const std::string_view& file, OpenMethod method, AccessHint hint = AccessHint::Normal, bool unbuffered = false);
+
+	ReadWriteFile(const ReadWriteFile&) = delete;
+	ReadWriteFile& operator=(const ReadWriteFile&) = delete;
 
 	bool IsValid() const;
 
-	bool Write(const char* src, unsigned long count) const;
-	bool Read(char* dst, unsigned long count) const; // returns false if it has read nothing but the end of the file or an error has occured, otherwise true
+	// the handle stays open until 'Close' is called or the file is destroyed, every session reuses it
+	void Open();
+	void Close();
+	bool IsOpen() const;
 
+	// the counts can be larger than 4 GB, these are split up into multiple reads or writes
+	bool Write(const char* src, std::uint64_t count) const;
+	bool Read(char* dst, std::uint64_t count) const; // returns false if it has read nothing but the end of the file or an error has occured, otherwise true
+
+	// reads or writes at the given offset from the start of the file without using or moving the file pointer, these can be called from multiple threads at once
+	bool ReadAt(std::uint64_t offset, char* dst, std::uint64_t count) const;
+	bool WriteAt(std::uint64_t offset, const char* src, std::uint64_t count) const;
+
+	// a session opens the file if needed and moves the file pointer to the start of the file
 	void StartReading();
 	void StopReading();
 
@@ -36,7 +63,7 @@ public:
 	std::int64_t SeekG(std::int64_t index, ReadWriteFile::Method method) const;
 	std::int64_t GetG() const;
 
-	std::size_t GetFileSize() const;
+	std::uint64_t GetFileSize() const;
 
 private:
 	struct HandleDeleter
@@ -44,9 +71,17 @@ private:
 		void operator()(void* ptr) const;
 	};
 
+	bool ReadUnbuffered(std::uint64_t offset, char* dst, std::uint64_t count) const;
+
 	OpenMethod method;
+	AccessHint hint;
+	bool unbuffered;
+
 	std::string file;
 	std::unique_ptr<void, HandleDeleter> handle;
+	std::unique_ptr<void, HandleDeleter> unbufferedHandle; // only used for reading, writes would have to be aligned as well
+
+	mutable std::uint64_t position = 0; // the file pointer
 };
 
 export class ReadSession
@@ -0,0 +1,257 @@
+export module IO.Reflection;
+
+import "../glm.h";
+
+import std;
+
+import IO.BinaryStream;
+
+// the reflection layer turns a list of fields, declared once per type, into a serializer and a deserializer.
+// every type is written field by field in the order of its field list, the values are written like this:
+//
+// a reflected type: its fields
+// a string: a 32 bit length and the characters
+// a vector of trivially copyable values: a 64 bit count and the elements as a whole
+// any other vector: a 64 bit count and every element on its own
+// a glm vector or quaternion: its components, a quaternion is written as w, x, y, z
+// any other trivially copyable value: its bytes
+//
+// every field has the version in which it was added. a stream has one version for every type in it, so older streams can still
+// be read by skipping the fields they dont have. those fields keep the value they had before reading
+export namespace Reflection
+{
+	template<typename Class, typename Member>
+	struct Field
+	{
+		Member Class::* pMember;
+		std::uint32_t since = 0; // the first version that contains this field
+	};
+
+	/// <summary>
+	/// specialize this for a type to make it reflected, the specialization needs a 'fields' tuple of Field and the current 'version' of the type:
+	/// template<> struct Reflection::Schema<T> { static constexpr std::uint32_t version = 1; static constexpr auto fields = std::tuple{ Field{ &T::a }, Field{ &T::b, 1 } }; };
+	/// </summary>
+	template<typename T>
+	struct Schema;
+
+	template<typename T>
+	concept Reflected = requires { Schema<T>::fields; Schema<T>::version; };
+}
+
+namespace Reflection
+{
+	template<typename T>
+	struct IsVector : std::false_type {};
+
+	template<typename T, typename Allocator>
+	struct IsVector<std::vector<T, Allocator>> : std::true_type {};
+
+	template<typename T>
+	struct IsGlmVector : std::false_type {};
+
+	template<glm::length_t L, typename T, glm::qualifier Q>
+	struct IsGlmVector<glm::vec<L, T, Q>> : std::true_type {};
+
+	template<typename T>
+	struct IsGlmQuaternion : std::false_type {};
+
+	template<typename T, glm::qualifier Q>
+	struct IsGlmQuaternion<glm::qua<T, Q>> : std::true_type {};
+
+	// a vector of these can be copied as a whole, glm types are included since their padding is the same on both sides
+	template<typename T>
+	concept RawElement = std::is_trivially_copyable_v<T> && !Reflected<T>;
+
+	template<typename T>
+	std::size_t GetValueSize(const T& value, std::uint32_t version)
+	{
+		if constexpr (Reflected<T>)
+		{
+			return std::apply([&](const auto&... fields) { return ((fields.since <= version ? GetValueSize(value.*fields.pMember, version) : 0) + ... + 0); }, Schema<T>::fields);
+		}
+		else if constexpr (std::is_same_v<T, std::string>)
+		{
+			return sizeof(std::uint32_t) + value.size();
+		}
+		else if constexpr (IsVector<T>::value)
+		{
+			using Element = typename T::value_type;
+			if constexpr (RawElement<Element>)
+				return sizeof(std::uint64_t) + value.size() * sizeof(Element);
+			else
+				return std::accumulate(value.begin(), value.end(), sizeof(std::uint64_t), [&](std::size_t size, const Element& element) { return size + GetValueSize(element, version); });
+		}
+		else if constexpr (IsGlmVector<T>::value || IsGlmQuaternion<T>::value)
+		{
+			return T::length() * sizeof(typename T::value_type);
+		}
+		else
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "the type cannot be reflected, it needs a Reflection::Schema");
+			return sizeof(T);
+		}
+	}
+
+	template<typename T>
+	void WriteValue(BinaryStream& stream, const T& value, std::uint32_t version)
+	{
+		if constexpr (Reflected<T>)
+		{
+			std::apply([&](const auto&... fields) { ((fields.since <= version ? WriteValue(stream, value.*fields.pMember, version) : void()), ...); }, Schema<T>::fields);
+		}
+		else if constexpr (std::is_same_v<T, std::string>)
+		{
+			stream << static_cast<std::uint32_t>(value.size());
+			stream.WriteRange(value);
+		}
+		else if constexpr (IsVector<T>::value)
+		{
+			stream << static_cast<std::uint64_t>(value.size());
+			if constexpr (RawElement<typename T::value_type>)
+				stream.WriteRange(value);
+			else
+				for (const auto& element : value)
+					WriteValue(stream, element, version);
+		}
+		else if constexpr (IsGlmVector<T>::value)
+		{
+			for (glm::length_t i = 0; i < T::length(); i++)
+				stream << value[i];
+		}
+		else if constexpr (IsGlmQuaternion<T>::value)
+		{
+			stream << value.w << value.x << value.y << value.z;
+		}
+		else
+		{
+			stream.Write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+	}
+
+	inline std::size_t GetRemainingSize(const BinarySpan& stream)
+	{
+		return stream.data.size() - stream.GetOffset();
+	}
+
+	// returns false if the stream ends before the value does, the value is then only partially read
+	template<typename T>
+	bool ReadValue(const BinarySpan& stream, T& value, std::uint32_t version)
+	{
+		if constexpr (Reflected<T>)
+		{
+			return std::apply([&](const auto&... fields) { return ((fields.since > version || ReadValue(stream, value.*fields.pMember, version)) && ...); }, Schema<T>::fields);
+		}
+		else if constexpr (std::is_same_v<T, std::string>)
+		{
+			std::uint32_t size = 0;
+			if (!ReadValue(stream, size, version) || size > GetRemainingSize(stream))
+				return false;
+
+			value.resize(size);
+			stream.ReadRange(value);
+			return true;
+		}
+		else if constexpr (IsVector<T>::value)
+		{
+			using Element = typename T::value_type;
+
+			std::uint64_t count = 0;
+			if (!ReadValue(stream, count, version) || count > GetRemainingSize(stream)) // every element takes at least a byte, so a broken count is caught before resizing
+				return false;
+
+			if constexpr (RawElement<Element>)
+			{
+				if (count * sizeof(Element) > GetRemainingSize(stream))
+					return false;
+
+				value.resize(count);
+				stream.ReadRange(value);
+				return true;
+			}
+			else
+			{
+				value.resize(count);
+				return std::all_of(value.begin(), value.end(), [&](Element& element) { return ReadValue(stream, element, version); });
+			}
+		}
+		else if constexpr (IsGlmVector<T>::value || IsGlmQuaternion<T>::value)
+		{
+			if (T::length() * sizeof(typename T::value_type) > GetRemainingSize(stream))
+				return false;
+
+			if constexpr (IsGlmQuaternion<T>::value)
+				stream >> value.w >> value.x >> value.y >> value.z;
+			else
+				for (glm::length_t i = 0; i < T::length(); i++)
+					stream >> value[i];
+
+			return true;
+		}
+		else
+		{
+			if (sizeof(T) > GetRemainingSize(stream))
+				return false;
+
+			stream.Read(reinterpret_cast<char*>(&value), sizeof(T));
+			return true;
+		}
+	}
+}
+
+export namespace Reflection
+{
+	/// <summary>
+	/// calculates the amount of bytes Write will write for the value
+	/// </summary>
+	template<Reflected T>
+	std::size_t GetSerializedSize(const T& value, std::uint32_t version = Schema<T>::version)
+	{
+		return GetValueSize(value, version);
+	}
+
+	/// <summary>
+	/// writes the fields of the value without a version, the stream is grown once for the entire value
+	/// </summary>
+	template<Reflected T>
+	void Write(BinaryStream& stream, const T& value, std::uint32_t version = Schema<T>::version)
+	{
+		stream.Reserve(GetValueSize(value, version));
+		WriteValue(stream, value, version);
+	}
+
+	/// <summary>
+	/// reads the fields of the given version into the value, the fields that were added after that version are left untouched
+	/// </summary>
+	/// <returns>false if the stream is too short to contain the value</returns>
+	template<Reflected T>
+	bool Read(const BinarySpan& stream, T& value, std::uint32_t version = Schema<T>::version)
+	{
+		return ReadValue(stream, value, version);
+	}
+
+	/// <summary>
+	/// writes the current version of the type, followed by the value
+	/// </summary>
+	template<Reflected T>
+	void Serialize(BinaryStream& stream, const T& value)
+	{
+		stream.Reserve(sizeof(std::uint32_t) + GetValueSize(value, Schema<T>::version));
+
+		stream << Schema<T>::version;
+		WriteValue(stream, value, Schema<T>::version);
+	}
+
+	/// <summary>
+	/// reads a value written by Serialize with any version up to the current version of the type
+	/// </summary>
+	/// <returns>false if the version is newer than the current version or if the stream is too short</returns>
+	template<Reflected T>
+	bool Deserialize(const BinarySpan& stream, T& value)
+	{
+		std::uint32_t version = 0;
+		if (!ReadValue(stream, version, 0) || version > Schema<T>::version)
+			return false;
+
+		return ReadValue(stream, value, version);
+	}
+}
\ No newline at end of file
@@ -9,21 +9,33 @@ import <assimp/scene.h>;
 import std;
 
 import IO.DataArchiveFile;
+import IO.ArchiveCache;
 import IO.BinaryStream;
 import IO.CreationData;
+import IO.SceneStream;
+import IO.ImportCache;
 
 import Renderer.Material;
 import Renderer.Animation;
 import Renderer.Bone;
 import Renderer.Light;
 
+import System.TaskGraph;
+
 export class SceneLoader
 {
 public:
 	SceneLoader() = default;
-	SceneLoader(std::string sceneLocation);
+	SceneLoader(std::string sceneLocation, std::shared_ptr<ArchiveCache> cache = nullptr); // the cache is only used when loading archives
+
+	void LoadScene(); // reads, decodes and converts the scene on a task graph, the time spent in every stage is put into 'stageStatistics'
 
-	void LoadScene();
+	// makes LoadScene push every object and material into the stream as soon as it is complete, instead of putting them into 'objects' and 'materials'.
+	// the stream is finished when LoadScene returns, the animations are still put into 'animations'
+	void StreamTo(std::shared_ptr<SceneStream> stream);
+
+	// makes LoadScene look up files imported with assimp in the cache before importing them, and store them in it after importing them
+	void SetImportCache(std::shared_ptr<ImportCache> importCache);
 
 	std::vector<ObjectCreationData> objects;
 	std::vector<std::variant<MaterialCreationData, MaterialCreateInfo>> materials;
@@ -33,22 +45,40 @@ public:
 
 	size_t objectCount = 0; // the amount of objects read (not the same as objects.size(), which contains children)
 
+	std::vector<TaskGraph::StageStatistics> stageStatistics; // the stages of the last load
+
 private:
 	// file specific info
 	std::string header;
 	std::string location;
 
-	void LoadCustomFile();
-	void LoadAssimpFile();
+	std::shared_ptr<ArchiveCache> cache;
+	std::shared_ptr<SceneStream> stream;
+	std::shared_ptr<ImportCache> importCache;
+
+	struct ImportedScene;
+
+	void EmitObjects(std::size_t first); // moves the objects from 'first' onwards into the stream, if there is one
+	void EmitMaterial(std::size_t index); // moves the material into the stream, if there is one
+
+	void LoadCustomFile(TaskGraph& graph);
+	void LoadAssimpFile(TaskGraph& graph);
+	void ImportWithAssimp(TaskGraph& graph, std::shared_ptr<ImportedScene> imported);
+
+	bool LoadFromImportCache(const ImportCache::Key& key); // returns false if the cache has no usable entry for the file
+	void StoreInImportCache(const ImportCache::Key& key);
 
-	void LoadObjectsFromArchive(DataArchiveFile& file);
-	void LoadMaterialsFromArchive(DataArchiveFile& file);
+	void LoadObjectsFromArchive(TaskGraph& graph, DataArchiveFile& file, TaskGraph::TaskID materialRoot);
+	void LoadObjectsFromTable(DataArchiveFile& file, const std::span<const char>& table);
+	void LoadObjectsFromEntries(DataArchiveFile& file);
+	TaskGraph::TaskID LoadMaterialsFromArchive(TaskGraph& graph, const std::shared_ptr<DataArchiveFile>& file); // returns the task that reads the material table
+	void DecodeMaterial(TaskGraph& graph, const std::shared_ptr<DataArchiveFile>& file, const std::string& name, std::size_t index, DataArchiveFile::EntryView&& entry);
 
 	void RetrieveBoneData(MeshCreationData& creationData, const aiMesh* pMesh);
 	MeshCreationData RetrieveMeshData(aiMesh* pMesh);
 	void MergeMeshData(MeshCreationData& dst, aiMesh* pMesh);
 
-	ObjectCreationData RetrieveObject(const aiScene* scene, const aiNode* node, glm::mat4 parentTrans); // can return multiple objects if this one node has multiple meshes, but must of the time its one object
+	ObjectCreationData RetrieveObject(ImportedScene& imported, const aiNode* node, glm::mat4 parentTrans); // can return multiple objects if this one node has multiple meshes, but must of the time its one object
 
 	void ReadFullObject(DataArchiveFile& file, const BinarySpan& data, std::vector<ObjectCreationData>& outDst);
 
@@ -0,0 +1,80 @@
+export module IO.SceneStream;
+
+import std;
+
+import IO.CreationData;
+
+import Renderer.Material;
+
+/// <summary>
+/// Hands the objects and materials of a scene that is still loading to the scene that shows them. The loader pushes every object and material as soon as it is complete,
+/// and the scene takes them out a few at a time every frame, so a large scene appears progressively instead of all at once after a long hitch
+/// </summary>
+export class SceneStream
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using MaterialData = std::variant<MaterialCreationData, MaterialCreateInfo>;
+
+	struct Statistics
+	{
+		double timeToFirstObject = -1.0; // the milliseconds between creating the stream and adding its first object to the scene, -1 if that has not happened yet
+		double timeToComplete = -1.0;    // the milliseconds between creating the stream and adding its last object or material to the scene, -1 if that has not happened yet
+
+		std::uint64_t objectCount = 0;   // the amount of objects added to the scene so far
+		std::uint64_t materialCount = 0; // the amount of materials added to the scene so far
+		std::uint64_t frameCount = 0;    // the amount of frames that added something to the scene
+	};
+
+	// the functions that add the streamed data to the scene, these are only called from the thread that calls 'Integrate'
+	struct Integrator
+	{
+		std::function<void(std::size_t)> reserveMaterials;                   // called once with the amount of materials, before any material is added
+		std::function<void(std::size_t, MaterialData&)> addMaterial;         // the index is the index of the material in the loaded scene
+		std::function<void(ObjectCreationData&)> addObject;
+	};
+
+	SceneStream();
+
+	SceneStream(const SceneStream&) = delete;
+	SceneStream& operator=(const SceneStream&) = delete;
+
+	// these are called by the loader and can be called from any thread
+	void SetMaterialCount(std::size_t count);
+	void PushMaterial(std::size_t index, MaterialData&& data);
+	void PushObject(ObjectCreationData&& data);
+	void Finish(); // called once the loader will not push anything anymore, even if it failed
+
+	/// <summary>
+	/// adds the pushed materials and objects to the scene until the budget runs out. at least one item is added every call, so that the stream always makes progress.
+	/// the materials are added first, so that the objects that use them can find them
+	/// </summary>
+	/// <param name="budget">the amount of time that may be spent adding data</param>
+	/// <returns>true if the loader has finished and everything it pushed has been added</returns>
+	bool Integrate(Clock::duration budget, const Integrator& integrator);
+
+	bool IsComplete() const;
+	Statistics GetStatistics() const;
+
+private:
+	struct PendingMaterial
+	{
+		std::size_t index = 0;
+		MaterialData data;
+	};
+
+	// takes the next item out of the queues, returns false if there is nothing to take
+	bool Pop(std::optional<std::size_t>& materialCount, std::optional<PendingMaterial>& material, std::optional<ObjectCreationData>& object);
+
+	Clock::time_point start;
+
+	std::optional<std::size_t> materialCount; // only set until it has been handed to the integrator
+	std::deque<PendingMaterial> materials;
+	std::deque<ObjectCreationData> objects;
+
+	bool isFinished = false;
+	bool isComplete = false;
+
+	Statistics statistics{};
+	mutable std::mutex mutex;
+};
\ No newline at end of file
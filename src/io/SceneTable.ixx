@@ -0,0 +1,51 @@
+export module IO.SceneTable;
+
+import std;
+
+// the scene table stores the entire object hierarchy of a scene in a single archive entry, laid out like this:
+//
+// the header
+// record count amount of records, in depth first order so that every parent comes before its children
+// the blob, holding the names and the data of the objects
+//
+// every record has a fixed size, so the table can be read with a single copy and the hierarchy can be rebuilt without recursion.
+// since version 2 the data of meshes is stored in its own entry instead of in the blob, an unchanged mesh then keeps its entry
+// when the scene is saved again and identical meshes share a single entry
+export namespace SceneTable
+{
+	constexpr std::string_view ENTRY_NAME = "##scene_table";
+
+	constexpr std::uint32_t VERSION = 2; // version 1 stores the data of every object inside the blob
+	constexpr std::uint32_t NO_PARENT = std::numeric_limits<std::uint32_t>::max();
+
+	enum RecordFlags : std::uint32_t
+	{
+		RecordFlagNone = 0,
+		RecordFlagExternalPayload = 1 << 0, // the data of the object is stored in its own entry
+	};
+
+	struct Header
+	{
+		std::uint32_t version = VERSION;
+		std::uint32_t recordCount = 0;
+		std::uint64_t blobSize = 0;
+	};
+
+	struct Record
+	{
+		std::uint32_t parent = NO_PARENT; // the index of the record of the parent
+		std::int32_t type = 0;            // the Object::InheritType of the object
+
+		std::array<float, 3> position{};
+		std::array<float, 3> scale{};
+		std::array<float, 4> rotation{}; // w, x, y, z
+
+		std::uint64_t nameOffset = 0; // the offset of the name inside the blob
+		std::uint64_t payload = 0;    // the offset of the data of the object type inside the blob, or the ArchiveKey::hash of its entry with RecordFlagExternalPayload
+		std::uint64_t payloadSize = 0;
+		std::uint32_t nameLength = 0;
+		std::uint32_t flags = RecordFlagNone; // this was padding in version 1, which was always 0
+	};
+
+	static_assert(sizeof(Header) == 16 && sizeof(Record) == 80, "the scene table is written to disk as is, so its layout cannot change");
+}
\ No newline at end of file
@@ -12,13 +12,22 @@ import System.CriticalSection;
 
 import "../glm.h";
 
+// where the unanimated vertices of a skinned mesh are read from and where its animated vertices are written to, all in vertices
+export struct SkinnedMeshRange
+{
+	std::uint32_t sourceOffset = 0;      // into Renderer::g_defaultVertexBuffer
+	std::uint32_t skinningOffset = 0;    // into Renderer::g_skinningBuffer
+	std::uint32_t destinationOffset = 0; // into Renderer::g_vertexBuffer
+	std::uint32_t vertexCount = 0;
+};
+
 export class AnimationManager
 {
 public:
 	static AnimationManager* Get();
 
 	void ComputeAnimations(float delta);
-	void ApplyAnimations(const CommandBuffer& commandBuffer);
+	void ApplyAnimations(const CommandBuffer& commandBuffer, const std::span<const SkinnedMeshRange>& meshes);
 	void AddAnimation(const Animation& animation);
 	//void RemoveAnimation(Animation* animation);
 
@@ -11,8 +11,8 @@ import Renderer.Vertex;
 export class BottomLevelAccelerationStructure : public AccelerationStructure
 {
 public:
-	BottomLevelAccelerationStructure(StorageBuffer<Vertex>::Memory vertexMemory, StorageBuffer<std::uint32_t>::Memory indexMemory);
+	BottomLevelAccelerationStructure(StorageBuffer<PackedVertex>::Memory vertexMemory, IndexMemory indexMemory);
 
-	static BottomLevelAccelerationStructure* Create(StorageBuffer<Vertex>::Memory vertexMemory, StorageBuffer<std::uint32_t>::Memory indexMemory);
-	void RebuildGeometry(VkCommandBuffer commandBuffer, StorageBuffer<Vertex>::Memory vertexMemory, StorageBuffer<std::uint32_t>::Memory indexMemory);
+	static BottomLevelAccelerationStructure* Create(StorageBuffer<PackedVertex>::Memory vertexMemory, IndexMemory indexMemory);
+	void RebuildGeometry(VkCommandBuffer commandBuffer, StorageBuffer<PackedVertex>::Memory vertexMemory, IndexMemory indexMemory);
 };
\ No newline at end of file
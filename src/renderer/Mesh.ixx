@@ -9,6 +9,7 @@ import Renderer.Material;
 import Renderer;
 
 import IO.CreationData;
+import IO.BinaryStream;
 
 export enum MeshFlags
 {
@@ -26,14 +27,21 @@ export struct Mesh
 	static std::vector<Material> materials;
 
 	void Create(const MeshCreationData& creationData);
+
+	/// <summary>
+	/// creates the mesh from data written by Serialize. the geometry is stored in the exact layout it is uploaded in,
+	/// so it is copied as a whole instead of being parsed or packed again
+	/// </summary>
+	/// <returns>false if the payload is not a valid mesh, the mesh is left untouched in that case</returns>
+	bool Create(const std::span<const char>& payload);
+	void Serialize(BinaryStream& stream) const;
 	void Destroy();
 
 	void CopyFrom(const Mesh& mesh);
 
 	MeshHandle meshHandle;
 
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
+	PackedMesh geometry; // the CPU copy of what is uploaded
 
 	int faceCount = 0;
 	glm::vec3 min, max, center, extents;
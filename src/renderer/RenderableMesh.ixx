@@ -8,6 +8,8 @@ import Renderer.StorageBuffer;
 import Renderer.Vertex;
 import Renderer.BLAS;
 
+import <vulkan/vulkan.h>;
+
 export enum RenderableMeshFlagBits
 {
 	RenderableMeshFlagNone = 0,
@@ -20,10 +22,10 @@ export struct RenderableMesh
 {
 	glm::mat4 transform;
 
-	StorageBuffer<Vertex>::Memory dVertexMemory = 0;
-	StorageBuffer<Vertex>::Memory vertexMemory  = 0;
+	StorageBuffer<PackedVertex>::Memory dVertexMemory = 0;
+	StorageBuffer<PackedVertex>::Memory vertexMemory  = 0;
 
-	StorageBuffer<std::uint32_t>::Memory indexMemory = 0;
+	IndexMemory indexMemory;
 
 	std::shared_ptr<BottomLevelAccelerationStructure> BLAS;
 
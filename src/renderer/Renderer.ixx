@@ -45,11 +45,12 @@ concept InheritsRenderPipeline = std::is_base_of_v<RenderPipeline, T>;
 struct GpuMeshData
 {
 	GpuMeshData() = default;
-	GpuMeshData(StorageBuffer<Vertex>::Memory d, StorageBuffer<Vertex>::Memory v, StorageBuffer<std::uint32_t>::Memory i, const std::shared_ptr<BottomLevelAccelerationStructure>& b);
+	GpuMeshData(StorageBuffer<PackedVertex>::Memory d, StorageBuffer<SkinningData>::Memory s, StorageBuffer<PackedVertex>::Memory v, IndexMemory i, const std::shared_ptr<BottomLevelAccelerationStructure>& b);
 
-	StorageBuffer<Vertex>::Memory dVertices;
-	StorageBuffer<Vertex>::Memory vertices;
-	StorageBuffer<std::uint32_t>::Memory indices;
+	StorageBuffer<PackedVertex>::Memory dVertices; // only skinned meshes have these two
+	StorageBuffer<SkinningData>::Memory skinning;
+	StorageBuffer<PackedVertex>::Memory vertices;
+	IndexMemory indices;
 
 	std::shared_ptr<BottomLevelAccelerationStructure> BLAS; // probably better to make it anything but a shared_ptr
 
@@ -81,9 +82,11 @@ public:
 	static constexpr std::uint32_t LIGHT_BUFFER_BINDING      = 0;
 	static constexpr std::uint32_t SCENE_DATA_BUFFER_BINDING = 1;
 
-	static StorageBuffer<Vertex>        g_vertexBuffer;
+	static StorageBuffer<PackedVertex>  g_vertexBuffer;
 	static StorageBuffer<std::uint32_t> g_indexBuffer;
-	static StorageBuffer<Vertex>        g_defaultVertexBuffer;
+	static StorageBuffer<std::uint16_t> g_index16Buffer;       // the indices of the meshes with at most 65536 vertices
+	static StorageBuffer<PackedVertex>  g_defaultVertexBuffer; // the unanimated vertices of the skinned meshes, static meshes are only stored in g_vertexBuffer
+	static StorageBuffer<SkinningData>  g_skinningBuffer;      // the bones of the vertices in g_defaultVertexBuffer
 
 	static VkSampler defaultSampler;
 	static VkSampler noFilterSampler;
@@ -127,15 +130,21 @@ public:
 	void SetRenderMode(RenderMode mode);
 	RenderMode GetRenderMode() const;
 
-	MeshHandle LoadMesh(const std::span<const Vertex>& vertices, const std::span<const std::uint32_t>& indices);
+	// the data is uploaded as is, see PackedMesh. the skinning data is either empty or has one entry per vertex, 16 bit indices can only be used by meshes with at most 65536 vertices
+	MeshHandle LoadMesh(const std::span<const PackedVertex>& vertices, const std::span<const SkinningData>& skinning, const std::span<const std::uint16_t>& indices);
+	MeshHandle LoadMesh(const std::span<const PackedVertex>& vertices, const std::span<const SkinningData>& skinning, const std::span<const std::uint32_t>& indices);
 	bool CopyMeshHandle(const MeshHandle& handle);
 	void DestroyMeshHandle(const MeshHandle& handle);
 
 	void SetInternalResolutionScale(float scale);
 	static float GetInternalResolutionScale();
 
-	static void BindBuffersForRendering(CommandBuffer commandBuffer);
-	static void RenderMesh(CommandBuffer commandBuffer, const RenderableMesh& mesh, std::uint32_t instanceCount = 1);
+	static void BindBuffersForRendering(CommandBuffer commandBuffer); // binds the 32 bit index buffer
+	static void BindIndexBuffer(CommandBuffer commandBuffer, VkIndexType indexType);
+	static void RenderMesh(CommandBuffer commandBuffer, const RenderableMesh& mesh, std::uint32_t instanceCount = 1); // the index buffer of the index type of the mesh must be bound
+
+	static std::size_t GetIndexOffset(IndexMemory memory); // in indices, from the start of the index buffer of the type
+	static std::size_t GetIndexCount(IndexMemory memory);
 
 	static void SetViewport(CommandBuffer commandBuffer, VkExtent2D extent);
 	static void SetScissors(CommandBuffer commandBuffer, VkExtent2D extent);
@@ -307,7 +316,10 @@ private:
 	void PresentSwapchainImage(std::uint32_t frameIndex, std::uint32_t imageIndex);
 	void SubmitRenderingCommandBuffer(std::uint32_t frameIndex, std::uint32_t imageIndex);
 
+	MeshHandle AddMeshData(const std::span<const PackedVertex>& vertices, const std::span<const SkinningData>& skinning, IndexMemory indices); // meshDataCritSection has to be locked
+
 	std::optional<RenderableMesh> GetRenderableMeshFromObject(const Object* pObject); // assumes that the object is a MeshObject
+	std::vector<SkinnedMeshRange> GetSkinnedMeshRanges();
 	void GetAllObjectsFromObject(std::vector<RenderableMesh>& ret, std::vector<LightObject*>& lights, Object* obj, bool checkBLAS);
 };
 
@@ -14,8 +14,7 @@ public:
 	SimpleMesh& operator=(SimpleMesh&& rhs) noexcept;
 	SimpleMesh(const SimpleMesh&) = delete;
 
-	StorageBuffer<Vertex>::Memory vertexMemory = 0;
-	StorageBuffer<Vertex>::Memory defVertexMemory = 0;
+	StorageBuffer<PackedVertex>::Memory vertexMemory = 0;
 
 	void Destroy();
 
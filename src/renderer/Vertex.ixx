@@ -7,7 +7,9 @@ import "../glm.h";
 import std;
 
 export constexpr std::uint32_t MAX_BONES_PER_VERTEX = 4;
+export constexpr std::uint8_t  NO_BONE = 255; // a packed bone index of 255 is an unused slot, so a skinned mesh can have at most 255 bones
 
+// the vertex as it is imported and processed on the CPU, it is packed into a PackedVertex when it is uploaded
 export struct Vertex
 {
 	Vertex() = default;
@@ -21,61 +23,72 @@ export struct Vertex
 	int boneIndices[MAX_BONES_PER_VERTEX] = { -1, -1, -1, -1 };
 	float boneWeights[MAX_BONES_PER_VERTEX] = { 0.0f };
 
-	static VkVertexInputBindingDescription GetBindingDescription()
-	{
-		VkVertexInputBindingDescription bindingDescription{};
-
-		bindingDescription.binding = 0;
-		bindingDescription.stride = sizeof(Vertex);
-		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-		return bindingDescription;
-	}
-
-	static std::array<VkVertexInputAttributeDescription, 7> GetAttributeDescriptions()
-	{
-		std::array<VkVertexInputAttributeDescription, 7> descriptions{};
-
-		descriptions[0].binding = 0;
-		descriptions[0].location = 0;
-		descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-		descriptions[0].offset = offsetof(Vertex, position);
-
-		descriptions[1].binding = 0;
-		descriptions[1].location = 1;
-		descriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-		descriptions[1].offset = offsetof(Vertex, normal);
-
-		descriptions[2].binding = 0;
-		descriptions[2].location = 2;
-		descriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-		descriptions[2].offset = offsetof(Vertex, textureCoordinates);
-
-		descriptions[3].binding = 0;
-		descriptions[3].location = 3;
-		descriptions[3].format = VK_FORMAT_R32G32B32_SFLOAT;
-		descriptions[3].offset = offsetof(Vertex, tangent);
-
-		descriptions[4].binding = 0;
-		descriptions[4].location = 4;
-		descriptions[4].format = VK_FORMAT_R32G32B32_SFLOAT;
-		descriptions[4].offset = offsetof(Vertex, biTangent);
-
-		descriptions[5].binding = 0;
-		descriptions[5].location = 5;
-		descriptions[5].format = VK_FORMAT_R32G32B32A32_SINT;
-		descriptions[5].offset = offsetof(Vertex, boneIndices);
-
-		descriptions[6].binding = 0;
-		descriptions[6].location = 6;
-		descriptions[6].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-		descriptions[6].offset = offsetof(Vertex, boneWeights);
-
-		return descriptions;
-	}
+	bool HasBones() const;
 
 	bool operator==(const Vertex& vert2) const
 	{
 		return position == vert2.position && textureCoordinates == vert2.textureCoordinates && normal == vert2.normal;
 	}
+};
+
+/// <summary>
+/// The vertex as it is stored on the GPU, 24 bytes instead of the more than 80 bytes of a Vertex.
+/// The normal and tangent are octahedral encoded pairs of snorm16, the lowest bit of the tangent is the sign of the bitangent and the texture coordinates are half floats.
+/// The position stays a full float, because the acceleration structures are built from it and the skinning pass writes it
+/// </summary>
+export struct PackedVertex
+{
+	float position[3] = { 0.0f, 0.0f, 0.0f }; // not a glm::vec3, that is aligned to 16 bytes
+	std::uint32_t normal = 0;
+	std::uint32_t tangent = 0;
+	std::uint32_t textureCoordinates = 0;
+
+	static PackedVertex Pack(const Vertex& vertex);
+
+	static VkVertexInputBindingDescription GetBindingDescription();
+	static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions();
+};
+
+static_assert(sizeof(PackedVertex) == 24, "the shaders read the packed vertex as six 32 bit values");
+
+/// <summary>
+/// The bones of a vertex of a skinned mesh, stored apart from the vertices so that static meshes do not store any bone data.
+/// The weights are unorm8 and add up to 255, unused slots have NO_BONE as their index
+/// </summary>
+export struct SkinningData
+{
+	std::uint8_t boneIndices[MAX_BONES_PER_VERTEX] = { NO_BONE, NO_BONE, NO_BONE, NO_BONE };
+	std::uint8_t boneWeights[MAX_BONES_PER_VERTEX] = { 0, 0, 0, 0 };
+
+	static SkinningData Pack(const Vertex& vertex);
+};
+
+static_assert(sizeof(SkinningData) == 8, "the skinning shader reads the skinning data as two 32 bit values");
+
+/// <summary>
+/// The vertices, bones and indices of a mesh in the layout they are uploaded in.
+/// A mesh that can address all of its vertices with 16 bits only fills shortIndices, otherwise only indices is filled
+/// </summary>
+export struct PackedMesh
+{
+	static PackedMesh Pack(const std::span<const Vertex>& vertices, const std::span<const std::uint32_t>& indices);
+
+	std::vector<PackedVertex> vertices;
+	std::vector<SkinningData> skinning; // empty if none of the vertices have bones
+	std::vector<std::uint16_t> shortIndices;
+	std::vector<std::uint32_t> indices;
+
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+	std::size_t GetIndexCount() const;
+};
+
+/// <summary>
+/// The indices of a mesh. The type decides the buffer that holds them: Renderer::g_index16Buffer if it is VK_INDEX_TYPE_UINT16, otherwise Renderer::g_indexBuffer.
+/// Keeping the two together means a handle cannot be looked up in the buffer of the other index size
+/// </summary>
+export struct IndexMemory
+{
+	std::uintptr_t memory = 0;
+	VkIndexType type = VK_INDEX_TYPE_UINT32;
 };
\ No newline at end of file
@@ -0,0 +1,84 @@
+export module System.TaskGraph;
+
+import std;
+
+/// <summary>
+/// Runs tasks on a pool of threads as soon as every task they depend on has finished. Every task belongs to a stage, like reading or decoding,
+/// and the time spent in every stage is measured so that the slowest stage of a pipeline can be found
+/// </summary>
+export class TaskGraph
+{
+public:
+	using Task = std::function<void()>;
+	using TaskID = std::uint32_t;
+
+	struct StageStatistics
+	{
+		std::string name;
+		std::uint32_t taskCount = 0;
+		double wallTime = 0.0; // the milliseconds between the start of the first task and the end of the last task of the stage
+		double busyTime = 0.0; // the milliseconds spent in the tasks of the stage, summed over every thread
+
+		std::string ToString() const;
+	};
+
+	/// <param name="threadCount">the amount of worker threads, 0 uses the amount of hardware threads</param>
+	TaskGraph(std::uint32_t threadCount = 0);
+	~TaskGraph(); // finishes every added task before returning
+
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+
+	/// <summary>
+	/// adds a task that is started once all of its dependencies have finished. this can be called from inside of a task,
+	/// which is how a task adds the work it only discovers while running (like the textures of a material it has just read)
+	/// </summary>
+	/// <param name="stage">the name of the stage the task is timed under</param>
+	/// <param name="task">the task to run</param>
+	/// <param name="dependencies">the tasks that have to finish first, these must have been added before</param>
+	/// <returns>the id that other tasks can depend on</returns>
+	TaskID Add(std::string_view stage, Task task, const std::span<const TaskID>& dependencies = {});
+
+	void Wait(); // waits until every added task has finished, rethrows the first exception thrown by a task
+
+	std::vector<StageStatistics> GetStageStatistics() const; // the stages are in the order they were first used in
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Node
+	{
+		Task task;
+		std::uint32_t stage = 0;
+		std::uint32_t remainingDependencies = 0;
+		std::vector<TaskID> dependents;
+		bool isFinished = false;
+	};
+
+	struct Stage
+	{
+		std::string name;
+		std::uint32_t taskCount = 0;
+		Clock::duration busyTime{};
+		Clock::time_point firstStart = Clock::time_point::max();
+		Clock::time_point lastEnd = Clock::time_point::min();
+	};
+
+	std::uint32_t GetStageIndex(std::string_view name);
+	void Work();
+
+	std::deque<Node> nodes; // a deque so that adding a task never moves the other tasks
+	std::deque<TaskID> readyTasks;
+	std::vector<Stage> stages;
+
+	std::size_t pendingCount = 0; // the tasks that have been added but have not finished yet
+	std::exception_ptr exception;
+
+	bool isStopping = false;
+
+	mutable std::mutex mutex;
+	std::condition_variable taskAvailable;
+	std::condition_variable tasksCompleted;
+
+	std::vector<std::thread> threads;
+};
\ No newline at end of file
@@ -0,0 +1,275 @@
+// a round trip test of the portable I/O layer, this is built by CMakeLists.txt and run with ctest.
+// every check writes a file to the temporary directory, reads it back through the same layer the engine uses and compares the bytes
+import std;
+
+import IO.ReadWriteFile;
+import IO.FileMapping;
+import IO.DataArchiveFile;
+import IO.Compression;
+
+static constexpr std::uint64_t GIGABYTE = 1024ULL * 1024 * 1024;
+static constexpr std::uint64_t SECTOR_SIZE = 4096;
+
+static int failureCount = 0;
+
+static void Check(bool condition, std::string_view description)
+{
+	if (condition)
+		return;
+
+	std::cerr << "failed: " << description << '\n';
+	failureCount++;
+}
+
+static std::vector<char> CreatePattern(std::size_t size, std::uint32_t seed)
+{
+	std::vector<char> ret(size);
+	std::uint32_t state = seed;
+
+	for (char& c : ret) // a simple LCG, so that every offset has a different byte and shifted reads are caught
+	{
+		state = state * 1664525u + 1013904223u;
+		c = static_cast<char>(state >> 24);
+	}
+	return ret;
+}
+
+static bool Equals(const std::span<const char>& a, const std::span<const char>& b)
+{
+	return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+static void TestPositionalAccess(const std::string& path)
+{
+	std::vector<char> data = CreatePattern(3 * 1024 * 1024 + 17, 1);
+	std::vector<char> patch = CreatePattern(10'000, 2);
+
+	ReadWriteFile file(path, ReadWriteFile::OpenMethod::Clear);
+	file.Open();
+
+	Check(file.WriteAt(0, data.data(), data.size()), "WriteAt at the start of the file");
+	Check(file.WriteAt(SECTOR_SIZE + 1, patch.data(), patch.size()), "WriteAt at an unaligned offset");
+	Check(file.GetG() == 0, "WriteAt does not move the file pointer");
+
+	std::memcpy(data.data() + SECTOR_SIZE + 1, patch.data(), patch.size());
+
+	std::vector<char> read(data.size());
+	Check(file.ReadAt(0, read.data(), read.size()) && Equals(read, data), "ReadAt gives back what WriteAt wrote");
+	Check(file.GetFileSize() == data.size(), "the file size matches the written data");
+
+	// every thread reads its own ranges, the reads must not disturb each other
+	std::atomic<int> mismatches = 0;
+	std::vector<std::thread> threads;
+
+	for (std::uint32_t i = 0; i < 4; i++)
+		threads.emplace_back([&, i]()
+			{
+				std::mt19937 random(i);
+				for (int j = 0; j < 64; j++)
+				{
+					std::uint64_t offset = random() % data.size();
+					std::uint64_t count = std::min<std::uint64_t>(random() % 65536 + 1, data.size() - offset);
+
+					std::vector<char> part(count);
+					if (!file.ReadAt(offset, part.data(), count) || !Equals(part, std::span<const char>(data).subspan(offset, count)))
+						mismatches++;
+				}
+			}
+		);
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	Check(mismatches == 0, "concurrent ReadAt calls");
+	Check(!file.ReadAt(data.size() - 1, read.data(), 2), "ReadAt fails when it reads past the end of the file");
+}
+
+// the data is written past 4 GB into a sparse file, so the 64 bit offsets are tested without writing gigabytes to the disk
+static void TestLargeOffsets(const std::string& path)
+{
+	std::vector<char> data = CreatePattern(SECTOR_SIZE * 3 + 5, 3);
+	std::uint64_t offset = 5 * GIGABYTE + 3;
+
+	ReadWriteFile file(path, ReadWriteFile::OpenMethod::Clear);
+	file.Open();
+
+	Check(file.WriteAt(offset, data.data(), data.size()), "WriteAt past 4 GB");
+	Check(file.GetFileSize() == offset + data.size(), "the file size is larger than 4 GB");
+
+	std::vector<char> read(data.size());
+	Check(file.ReadAt(offset, read.data(), read.size()) && Equals(read, data), "ReadAt past 4 GB");
+
+	std::vector<char> hole(SECTOR_SIZE, 1);
+	Check(file.ReadAt(4 * GIGABYTE - SECTOR_SIZE / 2, hole.data(), hole.size()) && std::all_of(hole.begin(), hole.end(), [](char c) { return c == 0; }), "ReadAt across 4 GB in the unwritten part");
+
+	file.Close();
+	std::filesystem::remove(path);
+}
+
+static void TestAppend(const std::string& path)
+{
+	std::vector<char> first = CreatePattern(100'000, 4);
+	std::vector<char> second = CreatePattern(12'345, 5);
+
+	{
+		ReadWriteFile file(path, ReadWriteFile::OpenMethod::Clear);
+		WriteSession session(file);
+		Check(file.Write(first.data(), first.size()), "Write in a new file");
+	}
+	{
+		ReadWriteFile file(path, ReadWriteFile::OpenMethod::Append);
+		WriteSession session(file);
+
+		Check(file.GetFileSize() == first.size(), "Append keeps the existing data");
+
+		file.SeekG(0, ReadWriteFile::Method::End);
+		Check(file.Write(second.data(), second.size()), "Write at the end of the file");
+		Check(file.GetG() == static_cast<std::int64_t>(first.size() + second.size()), "Write moves the file pointer");
+	}
+
+	ReadWriteFile file(path, ReadWriteFile::OpenMethod::Append);
+	ReadSession session(file);
+
+	std::vector<char> read(first.size() + second.size());
+	Check(file.Read(read.data(), read.size()), "Read the appended file");
+	Check(Equals(std::span<const char>(read).first(first.size()), first) && Equals(std::span<const char>(read).subspan(first.size()), second), "the appended data follows the original data");
+}
+
+// unbuffered reads (O_DIRECT) have to be aligned to the sector size, the file aligns the requests that are not
+static void TestUnbuffered(const std::string& path)
+{
+	std::vector<char> data = CreatePattern(SECTOR_SIZE * 64 + 123, 6); // the end of the file is not aligned either
+
+	{
+		ReadWriteFile file(path, ReadWriteFile::OpenMethod::Clear);
+		file.Open();
+		file.WriteAt(0, data.data(), data.size());
+	}
+
+	ReadWriteFile file(path, ReadWriteFile::OpenMethod::Append, ReadWriteFile::AccessHint::Sequential, true);
+	file.Open();
+
+	struct AlignedDeleter
+	{
+		void operator()(char* ptr) const { ::operator delete[](ptr, std::align_val_t(SECTOR_SIZE)); }
+	};
+	std::unique_ptr<char[], AlignedDeleter> aligned(static_cast<char*>(::operator new[](SECTOR_SIZE * 8 + 1, std::align_val_t(SECTOR_SIZE))));
+	std::span<const char> expected(data);
+
+	Check(file.ReadAt(SECTOR_SIZE * 2, aligned.get(), SECTOR_SIZE * 4) && Equals({ aligned.get(), SECTOR_SIZE * 4 }, expected.subspan(SECTOR_SIZE * 2, SECTOR_SIZE * 4)), "an aligned unbuffered read");
+	Check(file.ReadAt(SECTOR_SIZE * 2, aligned.get() + 1, SECTOR_SIZE * 4) && Equals({ aligned.get() + 1, SECTOR_SIZE * 4 }, expected.subspan(SECTOR_SIZE * 2, SECTOR_SIZE * 4)), "an unbuffered read into unaligned memory");
+	Check(file.ReadAt(SECTOR_SIZE - 7, aligned.get(), 100) && Equals({ aligned.get(), 100 }, expected.subspan(SECTOR_SIZE - 7, 100)), "an unbuffered read across a sector boundary");
+
+	std::vector<char> tail(SECTOR_SIZE + 200);
+	std::uint64_t tailOffset = data.size() - tail.size();
+	Check(file.ReadAt(tailOffset, tail.data(), tail.size()) && Equals(tail, expected.subspan(tailOffset)), "an unbuffered read up to the unaligned end of the file");
+
+	std::vector<char> all(data.size());
+	Check(file.ReadAt(0, all.data(), all.size()) && Equals(all, data), "an unbuffered read of the entire file");
+	Check(!file.ReadAt(data.size() - 10, all.data(), 20), "an unbuffered read fails when it reads past the end of the file");
+}
+
+static void TestMapping(const std::string& path)
+{
+	std::vector<char> data = CreatePattern(1024 * 1024 + 3, 7);
+
+	{
+		ReadWriteFile file(path, ReadWriteFile::OpenMethod::Clear);
+		file.Open();
+		file.WriteAt(0, data.data(), data.size());
+	}
+
+	FileMapping mapping(path);
+	Check(mapping.IsValid(), "the file can be mapped");
+	Check(mapping.GetSize() == data.size() && Equals(mapping.GetView(), data), "the mapping views the file");
+
+	FileMapping missing(path + ".missing");
+	Check(!missing.IsValid() && missing.GetView().empty(), "a missing file cannot be mapped");
+}
+
+static void TestArchive(const std::string& path)
+{
+	// the codecs and sizes cover stored, compressed, dictionary sized and chunked entries
+	struct Entry
+	{
+		std::string name;
+		std::vector<char> data;
+		CompressionCodec codec;
+	};
+	std::vector<char> repeating(3 * 1024 * 1024);
+	for (std::size_t i = 0; i < repeating.size(); i++)
+		repeating[i] = static_cast<char>(i % 251);
+
+	std::vector<Entry> entries =
+	{
+		{ "stored", CreatePattern(70'000, 8), CompressionCodec::Store },
+		{ "small", std::vector<char>(1000, 'a'), CompressionCodec::LZ4 },
+		{ "lz4hc", CreatePattern(20'000, 9), CompressionCodec::LZ4HC },
+		{ "zstd", repeating, CompressionCodec::Zstd },
+		{ "chunked", repeating, CompressionCodec::LZ4 }, // the same data as "zstd" with another codec
+		{ "empty", {}, CompressionCodec::LZ4 },
+	};
+
+	{
+		DataArchiveFile archive(path, DataArchiveFile::OpenMethod::Clear);
+		for (const Entry& entry : entries)
+			Check(archive.AddData(entry.name, entry.data, entry.codec) == DataArchiveFile::Success, "AddData");
+
+		archive.WriteToFile();
+	}
+	{
+		DataArchiveFile archive(path, DataArchiveFile::OpenMethod::Append);
+		for (const Entry& entry : entries)
+		{
+			std::expected<std::vector<char>, DataArchiveFile::Result> data = archive.ReadData(entry.name);
+			Check(data.has_value() && Equals(*data, entry.data), "ReadData from disk");
+		}
+
+		Check(archive.AddData("appended", entries[0].data) == DataArchiveFile::Success, "AddData in a second session");
+		archive.WriteToFile();
+	}
+
+	DataArchiveFile archive(path, DataArchiveFile::OpenMethod::ReadOnly);
+	Check(archive.IsValid() && archive.IsReadOnly(), "the archive can be mapped");
+
+	std::expected<std::span<const char>, DataArchiveFile::Result> view = archive.ReadView("stored");
+	Check(view.has_value() && Equals(*view, entries[0].data), "ReadView of a stored entry");
+	Check(!archive.ReadView("zstd").has_value(), "ReadView of a compressed entry fails");
+
+	std::expected<std::vector<char>, DataArchiveFile::Result> appended = archive.ReadData("appended");
+	Check(appended.has_value() && Equals(*appended, entries[0].data), "ReadData of the entry from the second session");
+
+	std::vector<ArchiveKey> keys;
+	for (const Entry& entry : entries)
+		keys.push_back(entry.name);
+
+	std::vector<int> readCounts(entries.size());
+	archive.ReadBatch(keys, [&](std::size_t index, std::expected<DataArchiveFile::EntryView, DataArchiveFile::Result>&& entry)
+		{
+			readCounts[index]++;
+			Check(entry.has_value() && Equals(entry->data, entries[index].data), "ReadBatch gives the data of the key at the index");
+		}
+	);
+	Check(std::all_of(readCounts.begin(), readCounts.end(), [](int count) { return count == 1; }), "ReadBatch reads every key once");
+	Check(archive.ReadData("missing").error() == DataArchiveFile::IdentifierNotFound, "ReadData of a missing entry");
+}
+
+int main()
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "HalesiaIOTest";
+	std::filesystem::create_directories(directory);
+
+	TestPositionalAccess((directory / "positional.bin").string());
+	TestLargeOffsets((directory / "large.bin").string());
+	TestAppend((directory / "append.bin").string());
+	TestUnbuffered((directory / "unbuffered.bin").string());
+	TestMapping((directory / "mapping.bin").string());
+	TestArchive((directory / "archive.harc").string());
+
+	std::filesystem::remove_all(directory);
+
+	if (failureCount == 0)
+		std::cout << "all I/O checks passed\n";
+
+	return failureCount == 0 ? 0 : 1;
+}